@@ -0,0 +1,640 @@
+#ifndef PMS_ARROWWRITER_HPP
+#define PMS_ARROWWRITER_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fmt/format.h>
+#include <limits>
+#include <msf/BasicItem.hpp>
+#include <msf/binary.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace msf {
+namespace detail {
+
+/**
+ * @class FlatBuilder
+ * @brief a minimal flatbuffers builder for the metadata of the Arrow format,
+ * the buffer grows from its end so the children are built before their
+ * parents, and an object is referred to by its distance from the end
+ */
+class FlatBuilder {
+private:
+    // the buffer in reverse order
+    string rev_;
+    // the fields of the current table by id and position
+    std::vector<std::pair<unsigned, size_t>> fields_;
+    size_t table_start_;
+
+    void pad(size_t bytes, size_t align) {
+        while ((rev_.size() + bytes) % align != 0) {
+            rev_.push_back('\0');
+        }
+    }
+
+    void prepend(std::uint64_t value, size_t bytes) {
+        for (size_t i = bytes; i-- > 0;) {
+            rev_.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    size_t prepend_offset(size_t ref) {
+        pad(4, 4);
+        prepend(rev_.size() + 4 - ref, 4);
+        return rev_.size();
+    }
+
+public:
+    FlatBuilder() : table_start_(0) {}
+
+    size_t create_string(const string& value) {
+        pad(value.size() + 1, 4);
+        rev_.push_back('\0');
+        rev_.append(value.rbegin(), value.rend());
+        prepend(value.size(), 4);
+        return rev_.size();
+    }
+
+    /**
+     * @brief create a vector of structs
+     * @param bytes the structs in little-endian order
+     * @param count the count of structs
+     * @param align the alignment of the structs
+     */
+    size_t create_struct_vector(const string& bytes, size_t count,
+                                size_t align) {
+        pad(bytes.size(), std::max<size_t>(align, 4));
+        rev_.append(bytes.rbegin(), bytes.rend());
+        prepend(count, 4);
+        return rev_.size();
+    }
+
+    size_t create_table_vector(const std::vector<size_t>& refs) {
+        pad(refs.size() * 4, 4);
+        for (size_t i = refs.size(); i-- > 0;) {
+            prepend_offset(refs[i]);
+        }
+        prepend(refs.size(), 4);
+        return rev_.size();
+    }
+
+    void start_table() {
+        fields_.clear();
+        table_start_ = rev_.size();
+    }
+
+    void add_scalar(unsigned id, std::uint64_t value, size_t bytes) {
+        pad(bytes, bytes);
+        prepend(value, bytes);
+        fields_.emplace_back(id, rev_.size());
+    }
+
+    void add_offset(unsigned id, size_t ref) {
+        fields_.emplace_back(id, prepend_offset(ref));
+    }
+
+    /**
+     * @brief write the table and its vtable
+     * @return the reference of the table
+     */
+    size_t end_table() {
+        pad(4, 4);
+        prepend(0, 4);
+        size_t table = rev_.size();
+
+        std::vector<size_t> slots;
+        for (const auto& field : fields_) {
+            slots.resize(std::max<size_t>(slots.size(), field.first + 1), 0);
+            slots[field.first] = table - field.second;
+        }
+        for (size_t i = slots.size(); i-- > 0;) {
+            prepend(slots[i], 2);
+        }
+        prepend(table - table_start_, 2);
+        prepend(4 + 2 * slots.size(), 2);
+
+        // the vtable is found at the table minus this offset
+        std::uint64_t vtable = rev_.size() - table;
+        for (size_t i = 0; i < 4; ++i) {
+            rev_[table - 1 - i] = static_cast<char>(vtable >> (8 * i));
+        }
+        return table;
+    }
+
+    /**
+     * @brief write the offset of the root table
+     * @return the buffer, its size is a multiple of 8
+     */
+    string finish(size_t root) {
+        pad(4, 8);
+        prepend_offset(root);
+        return string(rev_.rbegin(), rev_.rend());
+    }
+};
+
+/**
+ * @brief the body of a record batch, the buffers are 8-byte aligned
+ */
+struct ArrowBody {
+    string data;
+    // the offset and the length of the buffers
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> buffers;
+    // the length and the null count of the columns
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> nodes;
+
+    /**
+     * @brief start a column without nulls, its validity buffer is empty
+     */
+    void add_node(size_t length) {
+        nodes.emplace_back(length, 0);
+        buffers.emplace_back(data.size(), 0);
+    }
+
+    void end_buffer(size_t start) {
+        buffers.emplace_back(start, data.size() - start);
+        data.resize((data.size() + 7) / 8 * 8, '\0');
+    }
+};
+
+// the ids of the types in the Type union of the Arrow schema
+enum class ArrowTypeId : std::uint8_t {
+    Int = 2,
+    FloatingPoint = 3,
+    Utf8 = 5,
+    Bool = 6,
+    Date = 8,
+    Time = 9,
+    Timestamp = 10
+};
+
+/**
+ * @brief the mapping of a field type to an Arrow type, with the type table
+ * of the schema and the encoding of a column
+ */
+template <typename Field>
+struct arrow_type;
+
+template <>
+struct arrow_type<IntegerField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Int;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        builder.add_scalar(0, 64, 4);
+        builder.add_scalar(1, 1, 1);
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            write_value(body.data, get(i));
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<FloatField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::FloatingPoint;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        // DOUBLE
+        builder.add_scalar(0, 2, 2);
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            write_value(body.data, get(i));
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<BooleanField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Bool;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        body.data.resize(start + (count + 7) / 8, '\0');
+        for (size_t i = 0; i < count; ++i) {
+            if (get(i)) {
+                body.data[start + i / 8] |= static_cast<char>(1 << (i % 8));
+            }
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<TextField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Utf8;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        size_t offset = 0;
+        write_unsigned(body.data, 0, 4);
+        for (size_t i = 0; i < count; ++i) {
+            offset += get(i).size();
+            if (offset > static_cast<size_t>(
+                             std::numeric_limits<std::int32_t>::max())) {
+                throw std::length_error(
+                    "text column exceeds the 32-bit offsets of utf8");
+            }
+            write_unsigned(body.data, offset, 4);
+        }
+        body.end_buffer(start);
+
+        start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            body.data.append(get(i));
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<DateField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Date;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        // DAY, date32
+        builder.add_scalar(0, 0, 2);
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            Integer days = get(i).days_since_epoch();
+            write_unsigned(body.data, static_cast<std::uint64_t>(days), 4);
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<TimeField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Time;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        // SECOND, time32
+        builder.add_scalar(0, 0, 2);
+        builder.add_scalar(1, 32, 4);
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            Integer seconds = get(i).seconds_of_day();
+            write_unsigned(body.data, static_cast<std::uint64_t>(seconds), 4);
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <>
+struct arrow_type<DateTimeField> {
+    static constexpr ArrowTypeId id = ArrowTypeId::Timestamp;
+
+    static size_t build(FlatBuilder& builder) {
+        builder.start_table();
+        // SECOND, without time zone
+        builder.add_scalar(0, 0, 2);
+        return builder.end_table();
+    }
+
+    template <typename Get>
+    static void encode(size_t count, Get get, ArrowBody& body) {
+        size_t start = body.data.size();
+        for (size_t i = 0; i < count; ++i) {
+            write_value(body.data, get(i).seconds_since_epoch());
+        }
+        body.end_buffer(start);
+    }
+};
+
+template <typename Item>
+auto arrow_field_name(size_t idx, int)
+    -> decltype(string(Item::get_field_names()[0])) {
+    return Item::get_field_names()[idx];
+}
+
+/**
+ * @brief the name of a field of the items without get_field_names()
+ */
+template <typename Item>
+string arrow_field_name(size_t idx, long) {
+    return fmt::format("field_{}", idx);
+}
+} // namespace detail
+
+/**
+ * @class ArrowWriter
+ * @brief the writer of the items to an Arrow IPC file, the items are written
+ * by column in record batches of a fixed count of rows
+ *
+ * The fields map to int64, float64, bool, utf8, date32, time32[s] and
+ * timestamp[s], none is nullable, and every field carries its type() as the
+ * "msf.type" metadata. The field names come from get_field_names() if the
+ * item type provides it.
+ * @tparam Item the type of the items
+ */
+template <typename Item>
+class ArrowWriter {
+public:
+    using names_array = std::array<string, Item::get_field_count()>;
+
+    static constexpr size_t default_batch_rows = 65536;
+
+private:
+    // the metadata version V5
+    static constexpr std::uint16_t metadata_version = 4;
+
+    std::ostream* out_;
+    names_array names_;
+    size_t batch_rows_;
+    std::uint64_t position_;
+    // the offset, the metadata length and the body length of the batches
+    string blocks_;
+    size_t batch_count_;
+    std::vector<Item> pending_;
+    bool closed_;
+
+    static names_array default_names() {
+        names_array res;
+        for (size_t i = 0; i < res.size(); ++i) {
+            res[i] = detail::arrow_field_name<Item>(i, 0);
+        }
+        return res;
+    }
+
+    void write_bytes(const string& bytes) {
+        out_->write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!*out_) {
+            throw std::runtime_error("unable to write the arrow file");
+        }
+        position_ += bytes.size();
+    }
+
+    template <size_t... Is>
+    std::vector<size_t> build_fields(detail::FlatBuilder& builder,
+                                     std::index_sequence<Is...>) const {
+        std::vector<size_t> res;
+        int order[] = {
+            0, (res.push_back(build_field<field_t<Is, Item>>(builder, Is)),
+                0)...};
+        static_cast<void>(order);
+        return res;
+    }
+
+    template <typename Field>
+    size_t build_field(detail::FlatBuilder& builder, size_t idx) const {
+        size_t name = builder.create_string(names_[idx]);
+        size_t key = builder.create_string("msf.type");
+        size_t value = builder.create_string(Field::type());
+        builder.start_table();
+        builder.add_offset(0, key);
+        builder.add_offset(1, value);
+        size_t metadata = builder.create_table_vector({builder.end_table()});
+        size_t children = builder.create_table_vector({});
+        size_t type = detail::arrow_type<Field>::build(builder);
+
+        builder.start_table();
+        builder.add_offset(0, name);
+        builder.add_scalar(1, 0, 1);
+        builder.add_scalar(
+            2, static_cast<std::uint8_t>(detail::arrow_type<Field>::id), 1);
+        builder.add_offset(3, type);
+        builder.add_offset(5, children);
+        builder.add_offset(6, metadata);
+        return builder.end_table();
+    }
+
+    size_t build_schema(detail::FlatBuilder& builder) const {
+        size_t fields = builder.create_table_vector(build_fields(
+            builder, std::make_index_sequence<Item::get_field_count()>()));
+        builder.start_table();
+        builder.add_offset(1, fields);
+        return builder.end_table();
+    }
+
+    /**
+     * @brief write an encapsulated message
+     * @param header_type the type of the header in the MessageHeader union
+     * @param header the reference of the header table
+     * @param body the body of the message
+     */
+    void write_message(detail::FlatBuilder& builder, std::uint8_t header_type,
+                       size_t header, const string& body) {
+        builder.start_table();
+        builder.add_scalar(3, body.size(), 8);
+        builder.add_offset(2, header);
+        builder.add_scalar(0, metadata_version, 2);
+        builder.add_scalar(1, header_type, 1);
+        string metadata = builder.finish(builder.end_table());
+
+        std::uint64_t offset = position_;
+        string prefix;
+        write_unsigned(prefix, 0xFFFFFFFF, 4);
+        write_unsigned(prefix, metadata.size(), 4);
+        write_bytes(prefix);
+        write_bytes(metadata);
+        write_bytes(body);
+
+        if (header_type == 3) {
+            write_unsigned(blocks_, offset, 8);
+            write_unsigned(blocks_, prefix.size() + metadata.size(), 4);
+            write_unsigned(blocks_, 0, 4);
+            write_unsigned(blocks_, body.size(), 8);
+        }
+    }
+
+    template <size_t... Is>
+    static void encode_fields(const Item* items, size_t count,
+                              detail::ArrowBody& body,
+                              std::index_sequence<Is...>) {
+        int order[] = {
+            0,
+            (body.add_node(count),
+             detail::arrow_type<field_t<Is, Item>>::encode(
+                 count,
+                 [items](size_t i) -> const auto& {
+                     return items[i].template get_field_value<Is>();
+                 },
+                 body),
+             0)...};
+        static_cast<void>(order);
+    }
+
+    void write_batch(const Item* items, size_t count) {
+        detail::ArrowBody body;
+        encode_fields(items, count, body,
+                      std::make_index_sequence<Item::get_field_count()>());
+
+        detail::FlatBuilder builder;
+        string structs;
+        for (const auto& node : body.nodes) {
+            write_unsigned(structs, node.first, 8);
+            write_unsigned(structs, node.second, 8);
+        }
+        size_t nodes =
+            builder.create_struct_vector(structs, body.nodes.size(), 8);
+        structs.clear();
+        for (const auto& buffer : body.buffers) {
+            write_unsigned(structs, buffer.first, 8);
+            write_unsigned(structs, buffer.second, 8);
+        }
+        size_t buffers =
+            builder.create_struct_vector(structs, body.buffers.size(), 8);
+
+        builder.start_table();
+        builder.add_scalar(0, count, 8);
+        builder.add_offset(1, nodes);
+        builder.add_offset(2, buffers);
+        write_message(builder, 3, builder.end_table(), body.data);
+        ++batch_count_;
+    }
+
+    void check_open() const {
+        if (closed_) {
+            throw std::runtime_error("the arrow writer is closed");
+        }
+    }
+
+public:
+    /**
+     * @brief start an Arrow file with the schema of the items
+     * @param out the stream of the file
+     * @param names the names of the fields
+     * @param batch_rows the count of rows per record batch
+     */
+    ArrowWriter(std::ostream& out, const names_array& names,
+                size_t batch_rows = default_batch_rows)
+        : out_(&out), names_(names),
+          batch_rows_(std::max<size_t>(1, batch_rows)), position_(0),
+          batch_count_(0), closed_(false) {
+        write_bytes(string("ARROW1\0\0", 8));
+        detail::FlatBuilder builder;
+        write_message(builder, 1, build_schema(builder), string());
+    }
+
+    explicit ArrowWriter(std::ostream& out,
+                         size_t batch_rows = default_batch_rows)
+        : ArrowWriter(out, default_names(), batch_rows) {}
+
+    ArrowWriter(const ArrowWriter& rhs) = delete;
+    ArrowWriter& operator=(const ArrowWriter& rhs) = delete;
+
+    /**
+     * @brief add an item, a batch is written once enough items are added
+     * @param item the item
+     */
+    void write(const Item& item) {
+        check_open();
+        pending_.push_back(item);
+        if (pending_.size() == batch_rows_) {
+            write_batch(pending_.data(), pending_.size());
+            pending_.clear();
+        }
+    }
+
+    /**
+     * @brief add a collection, the full batches are encoded straight from the
+     * collection without copying the items
+     * @param items the items
+     */
+    void write(const std::vector<Item>& items) {
+        check_open();
+        size_t pos = 0;
+        while (!pending_.empty() && pos < items.size()) {
+            write(items[pos++]);
+        }
+        for (; items.size() - pos >= batch_rows_; pos += batch_rows_) {
+            write_batch(items.data() + pos, batch_rows_);
+        }
+        pending_.insert(pending_.end(), items.begin() + pos, items.end());
+    }
+
+    /**
+     * @brief write the last batch and the footer, the file is complete only
+     * after the writer is closed
+     */
+    void close() {
+        check_open();
+        if (!pending_.empty()) {
+            write_batch(pending_.data(), pending_.size());
+            pending_.clear();
+        }
+        string eos;
+        write_unsigned(eos, 0xFFFFFFFF, 4);
+        write_unsigned(eos, 0, 4);
+        write_bytes(eos);
+
+        detail::FlatBuilder builder;
+        size_t batches =
+            builder.create_struct_vector(blocks_, batch_count_, 8);
+        size_t schema = build_schema(builder);
+        builder.start_table();
+        builder.add_offset(3, batches);
+        builder.add_offset(1, schema);
+        builder.add_scalar(0, metadata_version, 2);
+        string footer = builder.finish(builder.end_table());
+        write_bytes(footer);
+
+        string trailer;
+        write_unsigned(trailer, footer.size(), 4);
+        trailer.append("ARROW1");
+        write_bytes(trailer);
+        closed_ = true;
+    }
+
+    size_t batch_count() const {
+        return batch_count_;
+    }
+};
+
+/**
+ * @brief write a collection to an Arrow IPC file
+ * @param out the stream of the file
+ * @param items the items
+ * @param batch_rows the count of rows per record batch
+ */
+template <typename Item>
+void write_arrow(std::ostream& out, const std::vector<Item>& items,
+                 size_t batch_rows = ArrowWriter<Item>::default_batch_rows) {
+    ArrowWriter<Item> writer(out, batch_rows);
+    writer.write(items);
+    writer.close();
+}
+} // namespace msf
+#endif
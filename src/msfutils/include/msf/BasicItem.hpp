@@ -3,9 +3,11 @@
 
 #include <array>
 #include <msf/fields.hpp>
+#include <msf/memory.hpp>
 #include <msf/types.hpp>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace msf {
 
@@ -50,23 +52,55 @@ private:
 
     /**
      * @brief the base case of the recursive function to iterate the fields
-     * @param field_strs the string array to receive the string values of the
      */
     template <size_t idx = 0>
-    typename std::enable_if_t<(idx == field_count), void>
-    iterate_field_type(cstr_array& field_strs) const {}
+    static typename std::enable_if_t<(idx == field_count), void>
+    iterate_field_type(cstr_array&) {}
 
     /**
      * @brief the non-base case of the recursive function to iterate the fields
      * @param field_values the string array to receive the string values of the
      */
     template <size_t idx = 0>
-    typename std::enable_if_t<(idx < field_count), void>
-    iterate_field_type(cstr_array& field_strs) const {
+    static typename std::enable_if_t<(idx < field_count), void>
+    iterate_field_type(cstr_array& field_strs) {
         field_strs.at(idx) = get_field_type<idx>();
         iterate_field_type<idx + 1>(field_strs);
     }
 
+    /**
+     * @brief sum the sizes of the fields
+     * @return the count of bytes
+     */
+    template <size_t... Is>
+    static constexpr size_t fields_inline_size(std::index_sequence<Is...>) {
+        size_t sizes[] = {
+            0, std::tuple_element_t<Is, Fields>::inline_size()...};
+        size_t res = 0;
+        for (auto size : sizes) {
+            res += size;
+        }
+        return res;
+    }
+
+    /**
+     * @brief the base case of the recursive function to iterate the fields
+     */
+    template <size_t idx = 0>
+    typename std::enable_if_t<(idx == field_count), void>
+    iterate_field_memory(std::array<MemoryUsage, field_count>&) const {}
+
+    /**
+     * @brief the non-base case of the recursive function to iterate the fields
+     * @param usages the array to receive the memory usage of the fields
+     */
+    template <size_t idx = 0>
+    typename std::enable_if_t<(idx < field_count), void>
+    iterate_field_memory(std::array<MemoryUsage, field_count>& usages) const {
+        usages.at(idx) = std::get<idx>(fields_).memory_usage();
+        iterate_field_memory<idx + 1>(usages);
+    }
+
 public:
     BasicItem() = default;
     template <typename... Var>
@@ -133,19 +167,74 @@ public:
      * @return the c-style string containing the type of the field
      */
     template <size_t idx, typename = std::enable_if_t<(idx < field_count)>>
-    constexpr c_string get_field_type() const {
-        return std::get<idx>(fields_).type();
+    static constexpr c_string get_field_type() {
+        return std::tuple_element_t<idx, Fields>::type();
     }
 
     /**
      * @brief get the types of the fields
      * @return the c-style string array containing the types of the fields
      */
-    constexpr cstr_array get_field_types() const {
+    static constexpr cstr_array get_field_types() {
         cstr_array res;
         iterate_field_type(res);
-        return std::move(res);
+        return res;
+    }
+
+    /**
+     * @brief get the size of an item
+     * @return the count of bytes
+     */
+    static constexpr size_t inline_size() {
+        return sizeof(BasicItem);
+    }
+
+    /**
+     * @brief get the padding between the fields of an item
+     * @return the count of bytes
+     */
+    static constexpr size_t padding_size() {
+        return inline_size() -
+            fields_inline_size(std::make_index_sequence<field_count>());
+    }
+
+    /**
+     * @brief get the memory of every field
+     * @return the memory usage by field index
+     */
+    std::array<MemoryUsage, field_count> field_memory_usage() const {
+        std::array<MemoryUsage, field_count> res;
+        iterate_field_memory(res);
+        return res;
+    }
+
+    /**
+     * @brief get the memory of the item, the padding between the fields is
+     * overhead
+     * @return the memory usage summed over the fields
+     */
+    MemoryUsage memory_usage() const {
+        MemoryUsage res {inline_size(), padding_size(), 0, 0};
+        for (const auto& usage : field_memory_usage()) {
+            res.overhead_bytes += usage.overhead_bytes;
+            res.heap_bytes += usage.heap_bytes;
+            res.wasted_bytes += usage.wasted_bytes;
+        }
+        return res;
     }
 };
+
+/**
+ * @brief the type of the Nth field of an item
+ */
+template <size_t N, typename Item>
+using field_t = std::tuple_element_t<N, typename Item::Fields>;
+
+/**
+ * @brief the type of the value of the Nth field of an item
+ */
+template <size_t N, typename Item>
+using field_value_t = std::decay_t<
+    decltype(std::declval<const Item&>().template get_field_value<N>())>;
 } // namespace msf
 #endif
@@ -46,12 +46,71 @@ struct Date {
             throw std::invalid_argument("invalid date");
         }
 
+        if (d == 30 && m == 2) {
+            throw std::invalid_argument("invalid date");
+        }
+
         if (d == 29 && m == 2 &&
             (y % 4 != 0 || (y % 100 == 0 && y % 400 != 0))) {
             throw std::invalid_argument("invalid date");
         }
     }
 
+    /**
+     * @brief check the validity of a date without throwing, applies the same
+     * checks as the validating constructor
+     * @param y the year
+     * @param m the month
+     * @param d the day
+     * @return true if the date is valid
+     */
+    static constexpr bool is_valid(Integer y, Integer m, Integer d) {
+        return m >= 1 && m <= 12 && d >= 1 && d <= 31 &&
+            !(d == 31 && (m == 2 || m == 4 || m == 6 || m == 9 || m == 11)) &&
+            !(d == 30 && m == 2) &&
+            !(d == 29 && m == 2 &&
+              (y % 4 != 0 || (y % 100 == 0 && y % 400 != 0)));
+    }
+
+    /**
+     * @brief get the count of days since 1970-01-01, negative for the dates
+     * before it
+     * @return the count of days
+     */
+    Integer days_since_epoch() const {
+        // shift the year to begin at March so that Feb 29 is the last day
+        Integer y = year - (month <= 2 ? 1 : 0);
+        Integer era = (y >= 0 ? y : y - 399) / 400;
+        Integer year_of_era = y - era * 400;
+        Integer day_of_year = (153 * ((month + 9) % 12) + 2) / 5 + day - 1;
+        Integer day_of_era = year_of_era * 365 + year_of_era / 4 -
+            year_of_era / 100 + day_of_year;
+        return era * 146097 + day_of_era - 719468;
+    }
+
+    /**
+     * @brief get the date from the count of days since 1970-01-01
+     * @param days the count of days
+     * @return the date
+     */
+    static Date from_days_since_epoch(Integer days) {
+        days += 719468;
+        Integer era = (days >= 0 ? days : days - 146096) / 146097;
+        Integer day_of_era = days - era * 146097;
+        Integer year_of_era = (day_of_era - day_of_era / 1460 +
+                               day_of_era / 36524 - day_of_era / 146096) /
+            365;
+        Integer day_of_year = day_of_era -
+            (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        Integer shifted_month = (5 * day_of_year + 2) / 153;
+
+        Date res;
+        res.day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+        res.month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+        res.year = year_of_era + era * 400 + (res.month <= 2 ? 1 : 0);
+        return res;
+    }
+
     friend bool operator<(const Date& lhs, const Date& rhs) {
         if (lhs.year < rhs.year) {
             return true;
@@ -134,6 +193,39 @@ struct Time {
         }
     }
 
+    /**
+     * @brief check the validity of a time without throwing, applies the same
+     * checks as the validating constructor
+     * @param h the hour
+     * @param m the minute
+     * @param s the second
+     * @return true if the time is valid
+     */
+    static constexpr bool is_valid(Integer h, Integer m, Integer s) {
+        return h >= 0 && h < 24 && m >= 0 && m < 60 && s >= 0 && s < 60;
+    }
+
+    /**
+     * @brief get the count of seconds since midnight
+     * @return the count of seconds
+     */
+    Integer seconds_of_day() const {
+        return hour * 3600 + minute * 60 + second;
+    }
+
+    /**
+     * @brief get the time from the count of seconds since midnight
+     * @param seconds the count of seconds, in [0, 86400)
+     * @return the time
+     */
+    static Time from_seconds_of_day(Integer seconds) {
+        Time res;
+        res.hour = seconds / 3600;
+        res.minute = seconds / 60 % 60;
+        res.second = seconds % 60;
+        return res;
+    }
+
     friend bool operator<(const Time& lhs, const Time& rhs) {
         if (lhs.hour < rhs.hour) {
             return true;
@@ -190,6 +282,34 @@ struct DateTime : public Date, public Time {
     DateTime& operator=(const DateTime& rhs) = default;
     DateTime& operator=(DateTime&& rhs) noexcept = default;
 
+    /**
+     * @brief get the count of seconds since 1970-01-01 00:00:00
+     * @return the count of seconds
+     */
+    Integer seconds_since_epoch() const {
+        return days_since_epoch() * 86400 + seconds_of_day();
+    }
+
+    /**
+     * @brief get the date time from the count of seconds since
+     * 1970-01-01 00:00:00
+     * @param seconds the count of seconds
+     * @return the date time
+     */
+    static DateTime from_seconds_since_epoch(Integer seconds) {
+        Integer days = seconds / 86400;
+        Integer rest = seconds % 86400;
+        if (rest < 0) {
+            rest += 86400;
+            --days;
+        }
+
+        DateTime res;
+        static_cast<Date&>(res) = Date::from_days_since_epoch(days);
+        static_cast<Time&>(res) = Time::from_seconds_of_day(rest);
+        return res;
+    }
+
     friend bool operator<(const DateTime& lhs, const DateTime& rhs) {
         if (Date(lhs) < Date(rhs)) {
             return true;
@@ -0,0 +1,448 @@
+#ifndef PMS_ITEMPOOL_HPP
+#define PMS_ITEMPOOL_HPP
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <msf/memory.hpp>
+#include <msf/types.hpp>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @brief the split of a handle word into the slot index and the generation
+ * @tparam Word the type of the handle
+ */
+template <typename Word>
+struct handle_traits;
+
+template <>
+struct handle_traits<std::uint32_t> {
+    // about a million slots and 4095 items per slot
+    static constexpr unsigned index_bits = 20;
+};
+
+template <>
+struct handle_traits<std::uint64_t> {
+    // about 4 billion slots and 4 billion items per slot
+    static constexpr unsigned index_bits = 32;
+};
+
+/**
+ * @class ItemPool
+ * @brief a pool placing items in fixed-size slabs, the items never move and
+ * are referred to by generational handles which become stale when the item
+ * is erased
+ *
+ * A handle is the index of the slot below the generation of the item. A slot
+ * is retired once it has held as many items as there are generations, so a
+ * stale handle never refers to a later item. The pool throws
+ * std::length_error when every index is used or retired.
+ * @tparam Item the type of the items
+ * @tparam Handle the type of the handles, std::uint32_t or std::uint64_t
+ * @tparam SlabSize the count of items per slab
+ */
+template <typename Item, typename Handle = std::uint64_t,
+          size_t SlabSize = 256>
+class ItemPool {
+public:
+    using handle_type = Handle;
+
+    // the handle never handed out
+    static constexpr handle_type null_handle = ~handle_type(0);
+
+private:
+    static constexpr unsigned index_bits = handle_traits<Handle>::index_bits;
+    static constexpr handle_type index_mask =
+        (handle_type(1) << index_bits) - 1;
+    static constexpr handle_type generation_mask =
+        ~handle_type(0) >> index_bits;
+
+    struct Slot {
+        typename std::aligned_storage<sizeof(Item), alignof(Item)>::type
+            storage;
+        // the generation of the current or the last item of the slot
+        handle_type generation;
+        // the epoch of the pool the slot was last used in
+        std::uint32_t epoch;
+        bool live;
+        // the item is not destroyed yet, true for the live items and for the
+        // items left by clear()
+        bool constructed;
+        // the position of the slot in the dense list
+        size_t dense;
+
+        Item* item() {
+            return reinterpret_cast<Item*>(&storage);
+        }
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    // the count of slots used since the last clear()
+    size_t high_water_;
+    std::vector<size_t> free_;
+    // the indices of the slots of the live items
+    std::vector<size_t> dense_;
+    std::uint32_t epoch_;
+
+    Slot& slot(size_t idx) const {
+        return slabs_[idx / SlabSize][idx % SlabSize];
+    }
+
+    /**
+     * @brief check whether a slot has used up its generations
+     */
+    static bool retired(const Slot& s) {
+        return s.generation == generation_mask;
+    }
+
+    Slot* find(handle_type handle) const {
+        size_t idx = static_cast<size_t>(handle & index_mask);
+        if (handle == null_handle || idx >= high_water_) {
+            return nullptr;
+        }
+        Slot& s = slot(idx);
+        if (!s.live || s.epoch != epoch_ ||
+            s.generation != (handle >> index_bits)) {
+            return nullptr;
+        }
+        return &s;
+    }
+
+    size_t acquire() {
+        size_t idx;
+        if (!free_.empty()) {
+            idx = free_.back();
+            free_.pop_back();
+        } else {
+            // the retired slots are skipped after clear()
+            while (high_water_ < capacity() && retired(slot(high_water_))) {
+                ++high_water_;
+            }
+            idx = high_water_;
+            // the last index is kept for null_handle
+            if (idx >= index_mask) {
+                throw std::length_error("item pool is full");
+            }
+            if (idx == capacity()) {
+                slabs_.emplace_back(new Slot[SlabSize]());
+            }
+            ++high_water_;
+        }
+
+        Slot& s = slot(idx);
+        // the items left by clear() are destroyed when their slot is reused
+        if (s.constructed) {
+            s.item()->~Item();
+            s.constructed = false;
+        }
+        s.live = false;
+        return idx;
+    }
+
+    template <typename Pool, typename Value>
+    class Iterator {
+    private:
+        Pool* pool_;
+        std::vector<size_t>::const_iterator it_;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator(Pool* pool, std::vector<size_t>::const_iterator it)
+            : pool_(pool), it_(it) {}
+
+        reference operator*() const {
+            return *pool_->slot(*it_).item();
+        }
+
+        pointer operator->() const {
+            return pool_->slot(*it_).item();
+        }
+
+        Iterator& operator++() {
+            ++it_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator res(*this);
+            ++it_;
+            return res;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.it_ == rhs.it_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.it_ != rhs.it_;
+        }
+    };
+
+    void destroy() noexcept {
+        for (size_t idx = 0; idx < capacity(); ++idx) {
+            if (slot(idx).constructed) {
+                slot(idx).item()->~Item();
+            }
+        }
+    }
+
+    /**
+     * @brief take the slabs of another pool and leave it empty, the handles
+     * of the items move with them
+     */
+    void take(ItemPool& rhs) noexcept {
+        slabs_ = std::move(rhs.slabs_);
+        high_water_ = rhs.high_water_;
+        free_ = std::move(rhs.free_);
+        dense_ = std::move(rhs.dense_);
+        epoch_ = rhs.epoch_;
+        rhs.slabs_.clear();
+        rhs.high_water_ = 0;
+        rhs.free_.clear();
+        rhs.dense_.clear();
+    }
+
+public:
+    using iterator = Iterator<ItemPool, Item>;
+    using const_iterator = Iterator<const ItemPool, const Item>;
+
+    ItemPool() : high_water_(0), epoch_(0) {}
+    ItemPool(const ItemPool& rhs) = delete;
+
+    ItemPool(ItemPool&& rhs) noexcept : ItemPool() {
+        take(rhs);
+    }
+
+    ~ItemPool() noexcept {
+        destroy();
+    }
+
+    ItemPool& operator=(const ItemPool& rhs) = delete;
+
+    ItemPool& operator=(ItemPool&& rhs) noexcept {
+        if (this != &rhs) {
+            destroy();
+            take(rhs);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief construct an item in the pool
+     * @param args the arguments of the constructor of the item
+     * @return the handle of the item
+     */
+    template <typename... Args>
+    handle_type emplace(Args&&... args) {
+        size_t idx = acquire();
+        Slot& s = slot(idx);
+        try {
+            new (&s.storage) Item(std::forward<Args>(args)...);
+        } catch (...) {
+            free_.push_back(idx);
+            throw;
+        }
+        s.constructed = true;
+        s.live = true;
+        s.epoch = epoch_;
+        s.generation = (s.generation + 1) & generation_mask;
+        s.dense = dense_.size();
+        dense_.push_back(idx);
+        return (s.generation << index_bits) | static_cast<handle_type>(idx);
+    }
+
+    handle_type insert(const Item& item) {
+        return emplace(item);
+    }
+
+    handle_type insert(Item&& item) {
+        return emplace(std::move(item));
+    }
+
+    /**
+     * @brief destroy an item, its handle becomes stale
+     * @param handle the handle of the item
+     * @return false if the handle is already stale
+     */
+    bool erase(handle_type handle) {
+        Slot* s = find(handle);
+        if (s == nullptr) {
+            return false;
+        }
+        s->item()->~Item();
+        s->constructed = false;
+        s->live = false;
+
+        size_t last = dense_.back();
+        dense_[s->dense] = last;
+        slot(last).dense = s->dense;
+        dense_.pop_back();
+        if (!retired(*s)) {
+            free_.push_back(static_cast<size_t>(handle & index_mask));
+        }
+        return true;
+    }
+
+    /**
+     * @brief check whether a handle refers to a live item
+     * @param handle the handle
+     * @return true if the handle is not stale
+     */
+    bool contains(handle_type handle) const {
+        return find(handle) != nullptr;
+    }
+
+    /**
+     * @brief get an item
+     * @param handle the handle of the item
+     * @return the pointer to the item, nullptr if the handle is stale
+     */
+    Item* get(handle_type handle) {
+        Slot* s = find(handle);
+        return s ? s->item() : nullptr;
+    }
+
+    const Item* get(handle_type handle) const {
+        Slot* s = find(handle);
+        return s ? s->item() : nullptr;
+    }
+
+    /**
+     * @brief get an item
+     * @param handle the handle of the item
+     * @return the reference of the item
+     */
+    Item& at(handle_type handle) {
+        Item* item = get(handle);
+        if (item == nullptr) {
+            throw std::out_of_range("stale item handle");
+        }
+        return *item;
+    }
+
+    const Item& at(handle_type handle) const {
+        const Item* item = get(handle);
+        if (item == nullptr) {
+            throw std::out_of_range("stale item handle");
+        }
+        return *item;
+    }
+
+    /**
+     * @brief erase every item in O(1), every handle becomes stale and the
+     * items are destroyed when their slots are reused, by release() or when
+     * the pool is destroyed
+     */
+    void clear() {
+        ++epoch_;
+        high_water_ = 0;
+        free_.clear();
+        dense_.clear();
+    }
+
+    /**
+     * @brief destroy the items left by clear() so their heap storage is
+     * freed, the slabs are kept
+     */
+    void release() {
+        for (size_t idx = 0; idx < capacity(); ++idx) {
+            Slot& s = slot(idx);
+            if (s.constructed && !(s.live && s.epoch == epoch_)) {
+                s.item()->~Item();
+                s.constructed = false;
+                s.live = false;
+            }
+        }
+    }
+
+    size_t size() const {
+        return dense_.size();
+    }
+
+    bool empty() const {
+        return dense_.empty();
+    }
+
+    /**
+     * @brief get the count of slots allocated in slabs
+     * @return the count of slots
+     */
+    size_t capacity() const {
+        return slabs_.size() * SlabSize;
+    }
+
+    /**
+     * @brief get the memory of the pool, the slots without a live item and
+     * the bookkeeping of the slots are wasted, the items left by clear() are
+     * wasted with their heap storage until release()
+     * @return the memory usage
+     */
+    MemoryUsage memory_usage() const {
+        MemoryUsage res {sizeof(ItemPool), 0, 0, 0};
+        res.heap_bytes = slabs_.capacity() * sizeof(slabs_[0]) +
+            capacity() * sizeof(Slot) +
+            (free_.capacity() + dense_.capacity()) * sizeof(size_t);
+        res.wasted_bytes = res.heap_bytes - size() * sizeof(Item);
+        for (size_t idx = 0; idx < capacity(); ++idx) {
+            Slot& s = slot(idx);
+            if (!s.constructed) {
+                continue;
+            }
+            MemoryUsage usage = detail::item_memory_usage(*s.item());
+            res.heap_bytes += usage.heap_bytes;
+            if (s.live && s.epoch == epoch_) {
+                res.overhead_bytes += usage.overhead_bytes;
+                res.wasted_bytes += usage.wasted_bytes;
+            } else {
+                res.wasted_bytes += usage.heap_bytes;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief visit the live items in dense order
+     * @param f the function called with the handle and the item
+     */
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto idx : dense_) {
+            Slot& s = slot(idx);
+            f((s.generation << index_bits) | static_cast<handle_type>(idx),
+              *s.item());
+        }
+    }
+
+    iterator begin() {
+        return iterator(this, dense_.cbegin());
+    }
+
+    iterator end() {
+        return iterator(this, dense_.cend());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, dense_.cbegin());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, dense_.cend());
+    }
+};
+
+template <typename Item, typename Handle, size_t SlabSize>
+constexpr typename ItemPool<Item, Handle, SlabSize>::handle_type
+    ItemPool<Item, Handle, SlabSize>::null_handle;
+} // namespace msf
+#endif
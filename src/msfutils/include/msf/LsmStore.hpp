@@ -0,0 +1,875 @@
+#ifndef PMS_LSMSTORE_HPP
+#define PMS_LSMSTORE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <map>
+#include <memory>
+#include <msf/BasicItem.hpp>
+#include <msf/binary.hpp>
+#include <msf/hash.hpp>
+#include <msf/types.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @class BloomFilter
+ * @brief a Bloom filter over 64-bit hashes, the probes are derived from the
+ * hash by double hashing
+ */
+class BloomFilter {
+private:
+    std::vector<std::uint64_t> words_;
+    unsigned hashes_;
+
+public:
+    BloomFilter() : hashes_(0) {}
+
+    /**
+     * @brief create an empty filter sized for a count of keys
+     * @param keys the count of keys
+     * @param bits_per_key the count of bits per key, 10 gives about 1% false
+     * positives
+     */
+    BloomFilter(size_t keys, size_t bits_per_key)
+        : words_((std::max<size_t>(64, keys * bits_per_key) + 63) / 64, 0),
+          // the optimal count of probes is bits_per_key * ln 2
+          hashes_(static_cast<unsigned>(std::min<size_t>(
+              30, std::max<size_t>(1, bits_per_key * 69 / 100)))) {}
+
+    /**
+     * @brief create a filter from its words
+     * @param words the words of the filter
+     * @param hashes the count of probes
+     */
+    BloomFilter(std::vector<std::uint64_t> words, unsigned hashes)
+        : words_(std::move(words)), hashes_(hashes) {}
+
+    BloomFilter(const BloomFilter& rhs) = default;
+    BloomFilter(BloomFilter&& rhs) noexcept = default;
+    ~BloomFilter() noexcept = default;
+
+    BloomFilter& operator=(const BloomFilter& rhs) = default;
+    BloomFilter& operator=(BloomFilter&& rhs) noexcept = default;
+
+    void insert(std::uint64_t hash) {
+        size_t bits = words_.size() * 64;
+        std::uint64_t step = value_hash::mix(hash) | 1;
+        for (unsigned i = 0; i < hashes_; ++i, hash += step) {
+            size_t bit = hash % bits;
+            words_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /**
+     * @brief check whether a hash may have been inserted
+     * @param hash the hash
+     * @return false if the hash was never inserted
+     */
+    bool may_contain(std::uint64_t hash) const {
+        if (words_.empty()) {
+            return true;
+        }
+        size_t bits = words_.size() * 64;
+        std::uint64_t step = value_hash::mix(hash) | 1;
+        for (unsigned i = 0; i < hashes_; ++i, hash += step) {
+            size_t bit = hash % bits;
+            if (!((words_[bit / 64] >> (bit % 64)) & 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::vector<std::uint64_t>& words() const {
+        return words_;
+    }
+
+    unsigned hashes() const {
+        return hashes_;
+    }
+};
+
+namespace detail {
+
+// the magic at the beginning and the end of a segment file
+constexpr c_string segment_magic = "MSFSEG01";
+constexpr size_t segment_magic_size = 8;
+// rows, bloom offset, bloom words, bloom probes and the magic
+constexpr size_t segment_footer_size = 4 * 8 + segment_magic_size;
+
+[[noreturn]] inline void throw_system_error(const string& what) {
+    throw std::runtime_error(fmt::format("{}: {}", what, std::strerror(errno)));
+}
+
+inline void write_fully(int fd, const string& data, const string& path) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t res = ::write(fd, data.data() + done, data.size() - done);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_system_error(fmt::format("unable to write {}", path));
+        }
+        done += static_cast<size_t>(res);
+    }
+}
+
+inline void read_fully(int fd, char* buf, size_t size, std::uint64_t offset,
+                       const string& path) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t res = ::pread(fd, buf + done, size - done,
+                              static_cast<off_t>(offset + done));
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            throw_system_error(fmt::format("unable to read {}", path));
+        }
+        done += static_cast<size_t>(res);
+    }
+}
+
+inline string segment_path(const string& directory, size_t sequence,
+                           size_t first_sequence) {
+    return fmt::format("{}/segment-{}-{}.msf", directory, sequence,
+                       first_sequence);
+}
+
+/**
+ * @brief the result of a point lookup in a table or a segment
+ */
+enum class Lookup { Missing, Found, Erased };
+
+/**
+ * @class LsmSegment
+ * @brief an immutable segment file of rows sorted by key, the keys and the
+ * row offsets are kept in memory and the rows are read on demand
+ *
+ * The file holds the magic, the rows, the words of the Bloom filter and a
+ * footer. A row is a flag byte telling whether it is live, the key and, for
+ * the live rows, the values of every field of the item.
+ */
+template <typename Item, size_t K>
+class LsmSegment {
+public:
+    using key_type = field_value_t<K, Item>;
+
+private:
+    string path_;
+    int fd_;
+    // the sequence of the newest and the oldest flush the segment holds
+    size_t sequence_;
+    size_t first_sequence_;
+    BloomFilter bloom_;
+    std::vector<key_type> keys_;
+    // the offsets of the rows followed by the end of the last row
+    std::vector<std::uint64_t> offsets_;
+    std::atomic<bool> obsolete_;
+
+public:
+    LsmSegment(string path, int fd, size_t sequence, size_t first_sequence,
+               BloomFilter bloom, std::vector<key_type> keys,
+               std::vector<std::uint64_t> offsets)
+        : path_(std::move(path)), fd_(fd), sequence_(sequence),
+          first_sequence_(first_sequence), bloom_(std::move(bloom)),
+          keys_(std::move(keys)), offsets_(std::move(offsets)),
+          obsolete_(false) {}
+
+    LsmSegment(const LsmSegment& rhs) = delete;
+    LsmSegment& operator=(const LsmSegment& rhs) = delete;
+
+    /**
+     * @brief close the file, and remove it if the segment has been merged
+     */
+    ~LsmSegment() noexcept {
+        ::close(fd_);
+        if (obsolete_) {
+            ::unlink(path_.c_str());
+        }
+    }
+
+    /**
+     * @brief open an existing segment file
+     * @param path the path of the file
+     * @param sequence the sequence of the newest flush in the segment
+     * @param first_sequence the sequence of the oldest flush in the segment
+     * @return the segment
+     */
+    static std::shared_ptr<LsmSegment> open(const string& path,
+                                            size_t sequence,
+                                            size_t first_sequence) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw_system_error(fmt::format("unable to open {}", path));
+        }
+        try {
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                throw_system_error(fmt::format("unable to stat {}", path));
+            }
+            string data(static_cast<size_t>(st.st_size), '\0');
+            read_fully(fd, &data[0], data.size(), 0, path);
+            if (data.size() < segment_magic_size + segment_footer_size ||
+                data.compare(0, segment_magic_size, segment_magic) != 0 ||
+                data.compare(data.size() - segment_magic_size,
+                             segment_magic_size, segment_magic) != 0) {
+                throw std::runtime_error(
+                    fmt::format("{} is not a segment file", path));
+            }
+
+            BinaryReader footer(data.data() + data.size() -
+                                    segment_footer_size,
+                                segment_footer_size);
+            size_t rows = footer.read_unsigned(8);
+            size_t bloom_offset = footer.read_unsigned(8);
+            size_t bloom_words = footer.read_unsigned(8);
+            std::uint64_t hashes = footer.read_unsigned(8);
+            // the footer is checked before anything is read by its offsets
+            size_t body_end = data.size() - segment_footer_size;
+            if (bloom_offset < segment_magic_size || bloom_offset > body_end ||
+                bloom_words > (body_end - bloom_offset) / 8 || hashes == 0 ||
+                hashes > 64) {
+                throw std::runtime_error(
+                    fmt::format("{} has a corrupt footer", path));
+            }
+
+            BinaryReader bloom_reader(data.data() + bloom_offset,
+                                      bloom_words * 8);
+            std::vector<std::uint64_t> words(bloom_words);
+            for (auto& word : words) {
+                word = bloom_reader.read_unsigned(8);
+            }
+
+            std::vector<key_type> keys;
+            std::vector<std::uint64_t> offsets;
+            BinaryReader reader(data.data() + segment_magic_size,
+                                bloom_offset - segment_magic_size);
+            Item scratch;
+            for (size_t i = 0; i < rows; ++i) {
+                offsets.push_back(bloom_offset - reader.remaining());
+                bool live;
+                key_type key;
+                reader.read_value(live);
+                reader.read_value(key);
+                if (live) {
+                    read_item(reader, scratch);
+                }
+                keys.push_back(std::move(key));
+            }
+            if (reader.remaining() != 0) {
+                throw std::runtime_error(
+                    fmt::format("{} has a corrupt footer", path));
+            }
+            offsets.push_back(bloom_offset);
+
+            return std::make_shared<LsmSegment>(
+                path, fd, sequence, first_sequence,
+                BloomFilter(std::move(words), static_cast<unsigned>(hashes)),
+                std::move(keys),
+                std::move(offsets));
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    size_t rows() const {
+        return keys_.size();
+    }
+
+    size_t sequence() const {
+        return sequence_;
+    }
+
+    size_t first_sequence() const {
+        return first_sequence_;
+    }
+
+    const key_type& key(size_t row) const {
+        return keys_[row];
+    }
+
+    /**
+     * @brief check the Bloom filter
+     * @param hash the hash of the key
+     * @return false if the key is surely not in the segment
+     */
+    bool may_contain(std::uint64_t hash) const {
+        return bloom_.may_contain(hash);
+    }
+
+    /**
+     * @brief read a row
+     * @param row the index of the row
+     * @param out the item to receive the values of a live row
+     * @return false if the row is a tombstone
+     */
+    bool read_row(size_t row, Item& out) const {
+        string buf(offsets_[row + 1] - offsets_[row], '\0');
+        read_fully(fd_, &buf[0], buf.size(), offsets_[row], path_);
+        BinaryReader reader(buf);
+        bool live;
+        key_type key;
+        reader.read_value(live);
+        reader.read_value(key);
+        if (live) {
+            read_item(reader, out);
+        }
+        return live;
+    }
+
+    /**
+     * @brief look up a key by a binary search over the keys
+     * @param key the key
+     * @param out the item to receive the values of the row
+     * @return the result of the lookup
+     */
+    Lookup find(const key_type& key, Item& out) const {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+        if (it == keys_.end() || !(*it == key)) {
+            return Lookup::Missing;
+        }
+        return read_row(it - keys_.begin(), out) ? Lookup::Found
+                                                 : Lookup::Erased;
+    }
+
+    /**
+     * @brief remove the file once the last reader releases the segment
+     */
+    void mark_obsolete() {
+        obsolete_ = true;
+    }
+};
+
+/**
+ * @class LsmSegmentWriter
+ * @brief the writer of a segment file, the rows must be added in key order
+ */
+template <typename Item, size_t K>
+class LsmSegmentWriter {
+public:
+    using key_type = field_value_t<K, Item>;
+
+private:
+    // the size of the buffered rows written at once
+    static constexpr size_t chunk_size = 1 << 16;
+
+    string path_;
+    string tmp_path_;
+    int fd_;
+    size_t sequence_;
+    size_t first_sequence_;
+    string buf_;
+    std::uint64_t offset_;
+    std::vector<key_type> keys_;
+    std::vector<std::uint64_t> offsets_;
+    std::vector<std::uint64_t> hashes_;
+
+public:
+    LsmSegmentWriter(const string& directory, size_t sequence,
+                     size_t first_sequence)
+        : path_(segment_path(directory, sequence, first_sequence)),
+          tmp_path_(path_ + ".tmp"), sequence_(sequence),
+          first_sequence_(first_sequence), buf_(segment_magic),
+          offset_(segment_magic_size) {
+        fd_ = ::open(tmp_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                     0644);
+        if (fd_ < 0) {
+            throw_system_error(fmt::format("unable to create {}", tmp_path_));
+        }
+    }
+
+    LsmSegmentWriter(const LsmSegmentWriter& rhs) = delete;
+    LsmSegmentWriter& operator=(const LsmSegmentWriter& rhs) = delete;
+
+    /**
+     * @brief remove the file if the segment is not finished
+     */
+    ~LsmSegmentWriter() noexcept {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            ::unlink(tmp_path_.c_str());
+        }
+    }
+
+    /**
+     * @brief append a row
+     * @param key the key of the row
+     * @param item the item, nullptr for a tombstone
+     */
+    void add(const key_type& key, const Item* item) {
+        size_t begin = buf_.size();
+        write_value(buf_, item != nullptr);
+        write_value(buf_, key);
+        if (item != nullptr) {
+            write_item(buf_, *item);
+        }
+        keys_.push_back(key);
+        offsets_.push_back(offset_);
+        hashes_.push_back(value_hash()(key));
+        offset_ += buf_.size() - begin;
+
+        if (buf_.size() >= chunk_size) {
+            write_fully(fd_, buf_, tmp_path_);
+            buf_.clear();
+        }
+    }
+
+    /**
+     * @brief write the Bloom filter and the footer and publish the file
+     * @param bits_per_key the count of bits of the Bloom filter per key
+     * @return the segment, nullptr if no row was added
+     */
+    std::shared_ptr<LsmSegment<Item, K>> finish(size_t bits_per_key) {
+        if (keys_.empty()) {
+            return nullptr;
+        }
+
+        BloomFilter bloom(keys_.size(), bits_per_key);
+        for (auto hash : hashes_) {
+            bloom.insert(hash);
+        }
+        std::uint64_t bloom_offset = offset_;
+        for (auto word : bloom.words()) {
+            write_unsigned(buf_, word, 8);
+        }
+        write_unsigned(buf_, keys_.size(), 8);
+        write_unsigned(buf_, bloom_offset, 8);
+        write_unsigned(buf_, bloom.words().size(), 8);
+        write_unsigned(buf_, bloom.hashes(), 8);
+        buf_.append(segment_magic, segment_magic_size);
+        write_fully(fd_, buf_, tmp_path_);
+
+        if (::fsync(fd_) != 0) {
+            throw_system_error(fmt::format("unable to sync {}", tmp_path_));
+        }
+        if (::rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+            throw_system_error(fmt::format("unable to rename {}", tmp_path_));
+        }
+        offsets_.push_back(bloom_offset);
+        auto res = std::make_shared<LsmSegment<Item, K>>(
+            path_, fd_, sequence_, first_sequence_, std::move(bloom),
+            std::move(keys_), std::move(offsets_));
+        fd_ = -1;
+        return res;
+    }
+};
+} // namespace detail
+
+/**
+ * @class LsmStore
+ * @brief a log-structured store of items keyed on one field, the writes go
+ * to a sorted in-memory table which is flushed to an immutable segment file
+ * when it is full, and a background thread flushes and merges the segments
+ * @tparam Item the type of the items, must be default constructible
+ * @tparam K the index of the key field
+ */
+template <typename Item, size_t K>
+class LsmStore {
+public:
+    using key_type = field_value_t<K, Item>;
+
+    static constexpr size_t default_memtable_rows = 4096;
+    static constexpr size_t default_compaction_trigger = 4;
+    static constexpr size_t default_bloom_bits_per_key = 10;
+
+private:
+    using Segment = detail::LsmSegment<Item, K>;
+    // a null item marks an erased key
+    using Memtable = std::map<key_type, std::unique_ptr<Item>>;
+
+    string directory_;
+    size_t memtable_rows_;
+    size_t compaction_trigger_;
+    size_t bloom_bits_per_key_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::unique_ptr<Memtable> memtable_;
+    // the full tables waiting to be flushed, the newest first
+    std::deque<std::shared_ptr<const Memtable>> immutables_;
+    // the newest first
+    std::vector<std::shared_ptr<Segment>> segments_;
+    size_t next_sequence_;
+    bool compact_requested_;
+    bool stop_;
+    std::exception_ptr error_;
+    mutable std::atomic<size_t> bloom_skips_;
+    std::thread worker_;
+
+    static detail::Lookup find_in(const Memtable& table, const key_type& key,
+                                  Item& out) {
+        auto it = table.find(key);
+        if (it == table.end()) {
+            return detail::Lookup::Missing;
+        }
+        if (it->second == nullptr) {
+            return detail::Lookup::Erased;
+        }
+        out = *it->second;
+        return detail::Lookup::Found;
+    }
+
+    /**
+     * @brief open the segments left in the directory, the segments covered by
+     * a merged segment are left over by an interrupted compaction and removed
+     */
+    void open_segments() {
+        if (::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+            detail::throw_system_error(
+                fmt::format("unable to create {}", directory_));
+        }
+        DIR* dir = ::opendir(directory_.c_str());
+        if (dir == nullptr) {
+            detail::throw_system_error(
+                fmt::format("unable to open {}", directory_));
+        }
+
+        std::vector<std::tuple<size_t, size_t, string>> files;
+        while (dirent* entry = ::readdir(dir)) {
+            string name = entry->d_name;
+            unsigned long long sequence;
+            unsigned long long first;
+            int consumed = 0;
+            if (std::sscanf(name.c_str(), "segment-%llu-%llu.msf%n", &sequence,
+                            &first, &consumed) != 2) {
+                continue;
+            }
+            string path = fmt::format("{}/{}", directory_, name);
+            if (static_cast<size_t>(consumed) != name.size()) {
+                // an unfinished segment
+                ::unlink(path.c_str());
+                continue;
+            }
+            files.emplace_back(sequence, first, path);
+            next_sequence_ = std::max<size_t>(next_sequence_, sequence + 1);
+        }
+        ::closedir(dir);
+
+        // the newest first, and the widest first among the same sequence
+        std::sort(files.begin(), files.end(), [](const auto& l, const auto& r) {
+            return std::get<0>(l) != std::get<0>(r)
+                ? std::get<0>(l) > std::get<0>(r)
+                : std::get<1>(l) < std::get<1>(r);
+        });
+        size_t covered_from = static_cast<size_t>(-1);
+        for (const auto& file : files) {
+            if (std::get<0>(file) >= covered_from) {
+                ::unlink(std::get<2>(file).c_str());
+                continue;
+            }
+            segments_.push_back(Segment::open(
+                std::get<2>(file), std::get<0>(file), std::get<1>(file)));
+            covered_from = std::get<1>(file);
+        }
+    }
+
+    /**
+     * @brief move the memtable to the queue of the background thread, the
+     * mutex must be held
+     */
+    void rotate() {
+        if (memtable_->empty()) {
+            return;
+        }
+        immutables_.push_front(std::shared_ptr<const Memtable>(
+            memtable_.release()));
+        memtable_.reset(new Memtable());
+        work_cv_.notify_one();
+    }
+
+    bool compaction_due() const {
+        return !stop_ &&
+            (compact_requested_ || segments_.size() >= compaction_trigger_);
+    }
+
+    void flush_oldest(std::unique_lock<std::mutex>& lock) {
+        auto table = immutables_.back();
+        size_t sequence = next_sequence_++;
+        lock.unlock();
+
+        detail::LsmSegmentWriter<Item, K> writer(directory_, sequence,
+                                                 sequence);
+        for (const auto& row : *table) {
+            writer.add(row.first, row.second.get());
+        }
+        auto segment = writer.finish(bloom_bits_per_key_);
+
+        lock.lock();
+        if (segment != nullptr) {
+            segments_.insert(segments_.begin(), segment);
+        }
+        immutables_.pop_back();
+    }
+
+    /**
+     * @brief merge every segment into one, the newest row of every key wins
+     * and the tombstones are dropped since no older segment remains
+     */
+    void compact_segments(std::unique_lock<std::mutex>& lock) {
+        auto inputs = segments_;
+        if (inputs.size() < 2) {
+            compact_requested_ = false;
+            return;
+        }
+        lock.unlock();
+
+        detail::LsmSegmentWriter<Item, K> writer(
+            directory_, inputs.front()->sequence(),
+            inputs.back()->first_sequence());
+        std::vector<size_t> cursors(inputs.size(), 0);
+        Item item;
+        while (true) {
+            const key_type* min = nullptr;
+            size_t newest = 0;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (cursors[i] < inputs[i]->rows() &&
+                    (min == nullptr || inputs[i]->key(cursors[i]) < *min)) {
+                    min = &inputs[i]->key(cursors[i]);
+                    newest = i;
+                }
+            }
+            if (min == nullptr) {
+                break;
+            }
+            if (inputs[newest]->read_row(cursors[newest], item)) {
+                writer.add(*min, &item);
+            }
+            key_type key = *min;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (cursors[i] < inputs[i]->rows() &&
+                    inputs[i]->key(cursors[i]) == key) {
+                    ++cursors[i];
+                }
+            }
+        }
+        auto merged = writer.finish(bloom_bits_per_key_);
+
+        lock.lock();
+        // the segments flushed meanwhile are in front of the inputs
+        segments_.erase(segments_.end() - inputs.size(), segments_.end());
+        if (merged != nullptr) {
+            segments_.push_back(merged);
+        }
+        for (auto& segment : inputs) {
+            segment->mark_obsolete();
+        }
+        compact_requested_ = false;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (error_ == nullptr) {
+            work_cv_.wait(lock, [this] {
+                return stop_ || !immutables_.empty() || compaction_due();
+            });
+            try {
+                if (!immutables_.empty()) {
+                    flush_oldest(lock);
+                } else if (compaction_due()) {
+                    compact_segments(lock);
+                } else {
+                    return;
+                }
+            } catch (...) {
+                if (!lock.owns_lock()) {
+                    lock.lock();
+                }
+                error_ = std::current_exception();
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    void rethrow_error() const {
+        if (error_ != nullptr) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+public:
+    /**
+     * @brief open a store in a directory, the segments left in it are opened
+     * @param directory the directory of the segment files
+     * @param memtable_rows the count of rows of the memtable before it is
+     * flushed
+     * @param compaction_trigger the count of segments which starts a merge
+     * @param bloom_bits_per_key the count of bits of the Bloom filters per key
+     */
+    explicit LsmStore(const string& directory,
+                      size_t memtable_rows = default_memtable_rows,
+                      size_t compaction_trigger = default_compaction_trigger,
+                      size_t bloom_bits_per_key = default_bloom_bits_per_key)
+        : directory_(directory),
+          memtable_rows_(std::max<size_t>(1, memtable_rows)),
+          compaction_trigger_(std::max<size_t>(2, compaction_trigger)),
+          bloom_bits_per_key_(bloom_bits_per_key), memtable_(new Memtable()),
+          next_sequence_(1), compact_requested_(false), stop_(false),
+          bloom_skips_(0) {
+        open_segments();
+        worker_ = std::thread([this] { run(); });
+    }
+
+    LsmStore(const LsmStore& rhs) = delete;
+    LsmStore& operator=(const LsmStore& rhs) = delete;
+
+    /**
+     * @brief flush the memtable and stop the background thread
+     */
+    ~LsmStore() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rotate();
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        worker_.join();
+    }
+
+    /**
+     * @brief insert or replace an item, the write never waits for a flush or
+     * a merge
+     * @param item the item
+     */
+    void put(const Item& item) {
+        std::unique_ptr<Item> copy(new Item(item));
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrow_error();
+        (*memtable_)[item.template get_field_value<K>()] = std::move(copy);
+        if (memtable_->size() >= memtable_rows_) {
+            rotate();
+        }
+    }
+
+    /**
+     * @brief erase the item of a key
+     * @param key the key
+     */
+    void erase(const key_type& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrow_error();
+        (*memtable_)[key].reset();
+        if (memtable_->size() >= memtable_rows_) {
+            rotate();
+        }
+    }
+
+    /**
+     * @brief look up a key, the segments whose Bloom filter rules the key out
+     * are skipped
+     * @param key the key
+     * @param out the item to receive the values
+     * @return true if the key is found
+     */
+    bool get(const key_type& key, Item& out) const {
+        std::vector<std::shared_ptr<Segment>> segments;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto res = find_in(*memtable_, key, out);
+            for (size_t i = 0;
+                 res == detail::Lookup::Missing && i < immutables_.size();
+                 ++i) {
+                res = find_in(*immutables_[i], key, out);
+            }
+            if (res != detail::Lookup::Missing) {
+                return res == detail::Lookup::Found;
+            }
+            segments = segments_;
+        }
+
+        std::uint64_t hash = value_hash()(key);
+        for (const auto& segment : segments) {
+            if (!segment->may_contain(hash)) {
+                ++bloom_skips_;
+                continue;
+            }
+            auto res = segment->find(key, out);
+            if (res != detail::Lookup::Missing) {
+                return res == detail::Lookup::Found;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief write the memtable to a segment and wait until every full table
+     * is flushed
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rotate();
+        done_cv_.wait(lock, [this] {
+            return immutables_.empty() || error_ != nullptr;
+        });
+        rethrow_error();
+    }
+
+    /**
+     * @brief flush the memtable and merge every segment into one, waiting
+     * until the merge is done
+     */
+    void compact() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rotate();
+        compact_requested_ = true;
+        work_cv_.notify_one();
+        done_cv_.wait(lock, [this] {
+            return (immutables_.empty() && !compact_requested_) ||
+                error_ != nullptr;
+        });
+        rethrow_error();
+    }
+
+    /**
+     * @brief wait until the background thread has flushed every full table
+     * and done the merges the segments call for
+     */
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] {
+            return (immutables_.empty() && !compaction_due()) ||
+                error_ != nullptr;
+        });
+        rethrow_error();
+    }
+
+    /**
+     * @brief get the count of segment files
+     * @return the count of segments
+     */
+    size_t segment_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return segments_.size();
+    }
+
+    /**
+     * @brief get the count of segments skipped by their Bloom filter so far
+     * @return the count of skipped segments
+     */
+    size_t bloom_skips() const {
+        return bloom_skips_;
+    }
+};
+} // namespace msf
+#endif
@@ -0,0 +1,320 @@
+#ifndef PMS_PARTITIONEDITEMS_HPP
+#define PMS_PARTITIONEDITEMS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <msf/BasicItem.hpp>
+#include <msf/DateTime.hpp>
+#include <msf/fields.hpp>
+#include <msf/memory.hpp>
+#include <msf/types.hpp>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @brief the span of time covered by one partition
+ */
+enum class PartitionGranularity { Month, Day };
+
+/**
+ * @class PartitionedItems
+ * @brief a collection of items bucketed by the month or the day of a date
+ * field, so the range queries only look at the partitions overlapping the
+ * range and the old partitions are dropped or archived as a whole
+ * @tparam Item the type of the items
+ * @tparam N the index of the DateField or DateTimeField
+ */
+template <typename Item, size_t N>
+class PartitionedItems {
+    static_assert(std::is_same<field_t<N, Item>, DateField>::value ||
+                      std::is_same<field_t<N, Item>, DateTimeField>::value,
+                  "the partition field must be a DateField or a DateTimeField");
+
+public:
+    using value_type = field_value_t<N, Item>;
+    using partition_type = std::vector<Item>;
+
+private:
+    PartitionGranularity granularity_;
+    // the partitions by key in ascending order of time
+    std::map<Integer, partition_type> partitions_;
+    size_t size_;
+
+    /**
+     * @brief visit the items of the partitions overlapping a range, the items
+     * of the partitions strictly inside the range are not compared
+     */
+    template <typename F>
+    void visit_range(const value_type& first, const value_type& last,
+                     F&& f) const {
+        if (last < first) {
+            return;
+        }
+        Integer first_key = partition_of(first);
+        Integer last_key = partition_of(last);
+        auto end = partitions_.upper_bound(last_key);
+        for (auto it = partitions_.lower_bound(first_key); it != end; ++it) {
+            bool inner = it->first != first_key && it->first != last_key;
+            f(it->second, inner);
+        }
+    }
+
+    template <typename F>
+    static void visit_items(const partition_type& items, bool inner,
+                            const value_type& first, const value_type& last,
+                            F& f) {
+        for (const auto& item : items) {
+            const auto& value = item.template get_field_value<N>();
+            if (inner || (!(value < first) && !(last < value))) {
+                f(item);
+            }
+        }
+    }
+
+public:
+    explicit PartitionedItems(
+        PartitionGranularity granularity = PartitionGranularity::Month)
+        : granularity_(granularity), size_(0) {}
+
+    PartitionedItems(const PartitionedItems& rhs) = default;
+    PartitionedItems(PartitionedItems&& rhs) noexcept = default;
+    ~PartitionedItems() noexcept = default;
+
+    PartitionedItems& operator=(const PartitionedItems& rhs) = default;
+    PartitionedItems& operator=(PartitionedItems&& rhs) noexcept = default;
+
+    PartitionGranularity granularity() const {
+        return granularity_;
+    }
+
+    /**
+     * @brief get the key of the partition of a date, the count of months
+     * since year 0 or the count of days since 1970-01-01
+     * @param date the date, or the date and time
+     * @return the key of the partition
+     */
+    Integer partition_of(const Date& date) const {
+        return granularity_ == PartitionGranularity::Month
+            ? date.year * 12 + date.month - 1
+            : date.days_since_epoch();
+    }
+
+    /**
+     * @brief get the first day of a partition
+     * @param key the key of the partition
+     * @return the first day
+     */
+    Date partition_start(Integer key) const {
+        if (granularity_ == PartitionGranularity::Day) {
+            return Date::from_days_since_epoch(key);
+        }
+        // floor division for the keys before year 0
+        Integer year = key >= 0 ? key / 12 : (key - 11) / 12;
+        return Date(year, key - year * 12 + 1, 1);
+    }
+
+    void insert(const Item& item) {
+        partitions_[partition_of(item.template get_field_value<N>())]
+            .push_back(item);
+        ++size_;
+    }
+
+    void insert(Item&& item) {
+        Integer key = partition_of(item.template get_field_value<N>());
+        partitions_[key].push_back(std::move(item));
+        ++size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t partition_count() const {
+        return partitions_.size();
+    }
+
+    /**
+     * @brief get the keys of the partitions
+     * @return the keys in ascending order of time
+     */
+    std::vector<Integer> partition_keys() const {
+        std::vector<Integer> res;
+        res.reserve(partitions_.size());
+        for (const auto& partition : partitions_) {
+            res.push_back(partition.first);
+        }
+        return res;
+    }
+
+    /**
+     * @brief get the memory of the collection, a partition costs a tree node
+     * of the value and about four pointers besides its items
+     * @return the memory usage
+     */
+    MemoryUsage memory_usage() const {
+        using Node = std::pair<const Integer, partition_type>;
+        MemoryUsage res {sizeof(PartitionedItems), 0, 0, 0};
+        for (const auto& partition : partitions_) {
+            MemoryUsage usage = msf::memory_usage(partition.second);
+            res.overhead_bytes += usage.overhead_bytes;
+            res.heap_bytes +=
+                sizeof(Node) + 4 * sizeof(void*) + usage.heap_bytes;
+            res.wasted_bytes += 4 * sizeof(void*) + usage.wasted_bytes;
+        }
+        return res;
+    }
+
+    /**
+     * @brief get the items of a partition
+     * @param key the key of the partition
+     * @return the pointer to the items, nullptr if the partition is absent
+     */
+    const partition_type* partition(Integer key) const {
+        auto it = partitions_.find(key);
+        return it == partitions_.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @brief remove a partition and hand its items over without copying them
+     * @param key the key of the partition
+     * @return the items of the partition, empty if the partition is absent
+     */
+    partition_type archive(Integer key) {
+        partition_type res;
+        auto it = partitions_.find(key);
+        if (it != partitions_.end()) {
+            res.swap(it->second);
+            partitions_.erase(it);
+            size_ -= res.size();
+        }
+        return res;
+    }
+
+    /**
+     * @brief remove a partition
+     * @param key the key of the partition
+     * @return false if the partition is absent
+     */
+    bool drop(Integer key) {
+        auto it = partitions_.find(key);
+        if (it == partitions_.end()) {
+            return false;
+        }
+        size_ -= it->second.size();
+        partitions_.erase(it);
+        return true;
+    }
+
+    /**
+     * @brief remove the partitions which end before a date, the retention
+     * purge never looks at the items
+     * @param date the first date to keep, the partition of the date is kept
+     * @return the count of removed items
+     */
+    size_t drop_before(const Date& date) {
+        auto end = partitions_.lower_bound(partition_of(date));
+        size_t removed = 0;
+        for (auto it = partitions_.begin(); it != end; ++it) {
+            removed += it->second.size();
+        }
+        partitions_.erase(partitions_.begin(), end);
+        size_ -= removed;
+        return removed;
+    }
+
+    /**
+     * @brief visit the items whose field is in a range
+     * @param first the first value of the range
+     * @param last the last value of the range, included
+     * @param f the function called with every item in the range
+     */
+    template <typename F>
+    void for_each_in_range(const value_type& first, const value_type& last,
+                           F&& f) const {
+        visit_range(first, last,
+                    [&](const partition_type& items, bool inner) {
+                        visit_items(items, inner, first, last, f);
+                    });
+    }
+
+    /**
+     * @brief collect the items whose field is in a range
+     * @param first the first value of the range
+     * @param last the last value of the range, included
+     * @return the pointers to the items in partition order
+     */
+    std::vector<const Item*> select_range(const value_type& first,
+                                          const value_type& last) const {
+        std::vector<const Item*> res;
+        for_each_in_range(first, last,
+                           [&res](const Item& item) { res.push_back(&item); });
+        return res;
+    }
+
+    /**
+     * @brief visit the items whose field is in a range with several threads,
+     * every partition is scanned by one thread
+     * @param first the first value of the range
+     * @param last the last value of the range, included
+     * @param f the function called concurrently with every item in the range
+     * @param threads the count of threads, 0 for the hardware concurrency
+     */
+    template <typename F>
+    void parallel_for_each_in_range(const value_type& first,
+                                    const value_type& last, F&& f,
+                                    size_t threads = 0) const {
+        std::vector<std::pair<const partition_type*, bool>> parts;
+        visit_range(first, last, [&parts](const partition_type& items,
+                                          bool inner) {
+            parts.emplace_back(&items, inner);
+        });
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, parts.size());
+
+        std::atomic<size_t> next_part(0);
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto worker = [&]() {
+            try {
+                for (size_t p = next_part++; p < parts.size();
+                     p = next_part++) {
+                    visit_items(*parts[p].first, parts[p].second, first, last,
+                                f);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+                next_part = parts.size();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+} // namespace msf
+#endif
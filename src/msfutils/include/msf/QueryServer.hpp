@@ -0,0 +1,744 @@
+#ifndef PMS_QUERYSERVER_HPP
+#define PMS_QUERYSERVER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <msf/BasicItem.hpp>
+#include <msf/binary.hpp>
+#include <msf/hash.hpp>
+#include <msf/types.hpp>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @brief the operations of the query protocol
+ *
+ * A frame is a u32 length followed by the body, all integers are
+ * little-endian and the values are written by write_value(). The body of a
+ * request is the u64 id, the u8 operation, the u64 field mask and:
+ * - Lookup: a u32 count and the keys
+ * - Scan: the first key, the last key and a u32 limit
+ *
+ * The body of a response is the id, the operation, a u8 status and the
+ * field mask of the request, followed by an error message if the status is
+ * not ok, else by a u32 count and the rows. A lookup row is a u8 flag telling
+ * whether the key is found followed by the fields of the mask if it is, a
+ * scan row is the fields of the mask. The responses of a connection come in
+ * the order of the requests.
+ */
+enum class QueryOp : std::uint8_t { Lookup = 1, Scan = 2 };
+
+enum class QueryStatus : std::uint8_t { Ok = 0, Error = 1 };
+
+// the mask selecting every field
+constexpr std::uint64_t all_fields = ~std::uint64_t(0);
+
+namespace detail {
+
+// the frames above this size close the connection
+constexpr size_t max_frame_size = 64 << 20;
+
+// a connection is not read while this many bytes of responses wait to be
+// sent
+constexpr size_t max_pending_output = 1 << 20;
+
+[[noreturn]] inline void throw_socket_error(const string& what) {
+    throw std::runtime_error(fmt::format("{}: {}", what, std::strerror(errno)));
+}
+
+inline sockaddr_un socket_address(const string& path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument(
+            fmt::format("socket path {} is too long", path));
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+/**
+ * @brief append a frame whose length is filled in by end_frame()
+ * @return the position of the length
+ */
+inline size_t begin_frame(string& out) {
+    size_t pos = out.size();
+    write_unsigned(out, 0, 4);
+    return pos;
+}
+
+inline void end_frame(string& out, size_t pos) {
+    std::uint64_t length = out.size() - pos - 4;
+    for (size_t i = 0; i < 4; ++i) {
+        out[pos + i] = static_cast<char>(length >> (8 * i));
+    }
+}
+} // namespace detail
+
+/**
+ * @class QueryServer
+ * @brief a server answering the lookups and the scans of a collection by key
+ * over a Unix domain socket, with an epoll event loop on one thread
+ *
+ * The requests of a connection are pipelined: every complete frame read is
+ * answered and the responses are written together once the input is
+ * drained. A connection whose responses pile up because its client does not
+ * read them is not read either until they are sent, and the input held for a
+ * connection never exceeds one frame and one read. A client closing its
+ * sending side still gets the responses of the requests it sent. The keys of
+ * the collection must be unique.
+ * @tparam Item the type of the items
+ * @tparam K the index of the key field
+ */
+template <typename Item, size_t K>
+class QueryServer {
+public:
+    using key_type = field_value_t<K, Item>;
+
+private:
+    struct Connection {
+        string in;
+        string out;
+        // the count of bytes of out already sent
+        size_t sent;
+        // the events the connection is watched for
+        std::uint32_t events;
+        // the client has closed its sending side
+        bool eof;
+    };
+
+    const std::vector<Item>* items_;
+    std::unordered_map<key_type, size_t, value_hash> index_;
+    // the rows in ascending order of key
+    std::vector<size_t> sorted_;
+    string path_;
+    int listen_fd_;
+    int stop_fd_;
+    int epoll_fd_;
+    std::unordered_map<int, Connection> connections_;
+
+    const key_type& key_of(size_t row) const {
+        return (*items_)[row].template get_field_value<K>();
+    }
+
+    void watch(int fd, std::uint32_t events, int op) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd_, op, fd, &event) != 0) {
+            detail::throw_socket_error("unable to watch socket");
+        }
+    }
+
+    void close_connection(int fd) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections_.erase(fd);
+    }
+
+    void accept_connections() {
+        while (true) {
+            int fd = ::accept4(listen_fd_, nullptr, nullptr,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // EAGAIN, or a client gone before it was accepted
+                return;
+            }
+            connections_[fd] = Connection {string(), string(), 0, EPOLLIN,
+                                           false};
+            try {
+                watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+            } catch (const std::exception&) {
+                ::close(fd);
+                connections_.erase(fd);
+            }
+        }
+    }
+
+    void lookup(BinaryReader& reader, std::uint64_t mask, string& out) const {
+        size_t count = static_cast<size_t>(reader.read_unsigned(4));
+        write_unsigned(out, count, 4);
+        key_type key;
+        for (size_t i = 0; i < count; ++i) {
+            reader.read_value(key);
+            auto it = index_.find(key);
+            write_value(out, it != index_.end());
+            if (it != index_.end()) {
+                write_item(out, (*items_)[it->second], mask);
+            }
+        }
+    }
+
+    void scan(BinaryReader& reader, std::uint64_t mask, string& out) const {
+        key_type first;
+        key_type last;
+        reader.read_value(first);
+        reader.read_value(last);
+        size_t limit = static_cast<size_t>(reader.read_unsigned(4));
+
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), first,
+                                   [this](size_t row, const key_type& key) {
+                                       return key_of(row) < key;
+                                   });
+        size_t count_pos = out.size();
+        write_unsigned(out, 0, 4);
+        size_t count = 0;
+        for (; it != sorted_.end() && count < limit && !(last < key_of(*it));
+             ++it, ++count) {
+            write_item(out, (*items_)[*it], mask);
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            out[count_pos + i] = static_cast<char>(count >> (8 * i));
+        }
+    }
+
+    /**
+     * @brief answer a request, a malformed request is answered with an error
+     * @param body the body of the request frame
+     * @param size the size of the body
+     * @param out the buffer to receive the response frame
+     */
+    void answer(const char* body, size_t size, string& out) const {
+        BinaryReader reader(body, size);
+        std::uint64_t id = 0;
+        std::uint8_t op = 0;
+        std::uint64_t mask = 0;
+        size_t frame = detail::begin_frame(out);
+        size_t header = out.size();
+        try {
+            id = reader.read_unsigned(8);
+            op = static_cast<std::uint8_t>(reader.read_unsigned(1));
+            mask = reader.read_unsigned(8);
+            write_unsigned(out, id, 8);
+            write_unsigned(out, op, 1);
+            write_unsigned(out, static_cast<std::uint8_t>(QueryStatus::Ok), 1);
+            write_unsigned(out, mask, 8);
+            if (op == static_cast<std::uint8_t>(QueryOp::Lookup)) {
+                lookup(reader, mask, out);
+            } else if (op == static_cast<std::uint8_t>(QueryOp::Scan)) {
+                scan(reader, mask, out);
+            } else {
+                throw std::invalid_argument(
+                    fmt::format("unknown query operation {}", op));
+            }
+        } catch (const std::exception& e) {
+            out.resize(header);
+            write_unsigned(out, id, 8);
+            write_unsigned(out, op, 1);
+            write_unsigned(out, static_cast<std::uint8_t>(QueryStatus::Error),
+                           1);
+            write_unsigned(out, mask, 8);
+            write_value(out, string(e.what()));
+        }
+        detail::end_frame(out, frame);
+    }
+
+    static size_t pending_output(const Connection& conn) {
+        return conn.out.size() - conn.sent;
+    }
+
+    /**
+     * @brief answer the complete frames read until the responses waiting to
+     * be sent reach max_pending_output
+     * @return false if a frame is too large and the connection is to be
+     * closed
+     */
+    bool answer_frames(Connection& conn) const {
+        size_t pos = 0;
+        while (conn.in.size() - pos >= 4 &&
+               pending_output(conn) < detail::max_pending_output) {
+            BinaryReader reader(conn.in.data() + pos, 4);
+            size_t length = static_cast<size_t>(reader.read_unsigned(4));
+            if (length > detail::max_frame_size) {
+                return false;
+            }
+            if (conn.in.size() - pos - 4 < length) {
+                break;
+            }
+            answer(conn.in.data() + pos + 4, length, conn.out);
+            pos += 4 + length;
+        }
+        conn.in.erase(0, pos);
+        return true;
+    }
+
+    /**
+     * @brief read what is available and answer every complete frame, the
+     * reading stops while the responses wait to be sent
+     * @return false if the connection is to be closed
+     */
+    bool read_requests(int fd, Connection& conn) const {
+        char buf[1 << 16];
+        while (pending_output(conn) < detail::max_pending_output &&
+               conn.in.size() < detail::max_frame_size + 4) {
+            ssize_t res = ::recv(fd, buf, sizeof(buf), 0);
+            if (res > 0) {
+                conn.in.append(buf, static_cast<size_t>(res));
+                if (!answer_frames(conn)) {
+                    return false;
+                }
+                continue;
+            }
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (res < 0) {
+                return false;
+            }
+            // the requests read before the end are still answered
+            conn.eof = true;
+            break;
+        }
+        return true;
+    }
+
+    /**
+     * @brief send the pending responses
+     * @return false if the connection is to be closed
+     */
+    bool write_responses(int fd, Connection& conn) const {
+        while (conn.sent < conn.out.size()) {
+            ssize_t res = ::send(fd, conn.out.data() + conn.sent,
+                                 conn.out.size() - conn.sent, MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (res < 0) {
+                return false;
+            }
+            conn.sent += static_cast<size_t>(res);
+        }
+        if (conn.sent == conn.out.size()) {
+            conn.out.clear();
+            conn.sent = 0;
+        }
+        return true;
+    }
+
+    /**
+     * @brief serve the events of a connection, the connection is watched for
+     * reading unless its responses pile up or its client has closed its
+     * sending side, and for writing while responses are left
+     * @return false if the connection is to be closed
+     */
+    bool serve(int fd, Connection& conn, std::uint32_t events) {
+        if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !conn.eof &&
+            !read_requests(fd, conn)) {
+            return false;
+        }
+        while (true) {
+            if (!write_responses(fd, conn)) {
+                return false;
+            }
+            if (!conn.out.empty()) {
+                break;
+            }
+            // the frames held back while the responses waited
+            if (!answer_frames(conn)) {
+                return false;
+            }
+            if (conn.out.empty()) {
+                break;
+            }
+        }
+        if (conn.eof && conn.out.empty()) {
+            return false;
+        }
+
+        std::uint32_t watched = 0;
+        if (!conn.eof && pending_output(conn) < detail::max_pending_output) {
+            watched |= EPOLLIN;
+        }
+        if (!conn.out.empty()) {
+            watched |= EPOLLOUT;
+        }
+        if (watched != conn.events) {
+            watch(fd, watched, EPOLL_CTL_MOD);
+            conn.events = watched;
+        }
+        return true;
+    }
+
+    void close_all() {
+        for (const auto& conn : connections_) {
+            ::close(conn.first);
+        }
+        connections_.clear();
+    }
+
+    void close_sockets() {
+        close_all();
+        for (int fd : {epoll_fd_, stop_fd_}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            ::unlink(path_.c_str());
+        }
+    }
+
+public:
+    /**
+     * @brief index a collection and listen on a socket, the collection must
+     * outlive the server and stay unchanged
+     * @param items the items, std::invalid_argument is thrown if two items
+     * have the same key
+     * @param path the path of the socket, replaced if it exists
+     */
+    QueryServer(const std::vector<Item>& items, const string& path)
+        : items_(&items), path_(path), listen_fd_(-1), stop_fd_(-1),
+          epoll_fd_(-1) {
+        index_.reserve(items.size());
+        sorted_.reserve(items.size());
+        for (size_t row = 0; row < items.size(); ++row) {
+            if (!index_.emplace(key_of(row), row).second) {
+                throw std::invalid_argument(
+                    fmt::format("duplicate key at row {}", row));
+            }
+            sorted_.push_back(row);
+        }
+        std::stable_sort(sorted_.begin(), sorted_.end(),
+                         [this](size_t lhs, size_t rhs) {
+                             return key_of(lhs) < key_of(rhs);
+                         });
+
+        sockaddr_un addr = detail::socket_address(path);
+        try {
+            listen_fd_ = ::socket(AF_UNIX,
+                                  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                  0);
+            if (listen_fd_ < 0) {
+                detail::throw_socket_error("unable to create socket");
+            }
+            ::unlink(path.c_str());
+            if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr),
+                       sizeof(addr)) != 0 ||
+                ::listen(listen_fd_, SOMAXCONN) != 0) {
+                detail::throw_socket_error(
+                    fmt::format("unable to listen on {}", path));
+            }
+            stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+            if (stop_fd_ < 0 || epoll_fd_ < 0) {
+                detail::throw_socket_error("unable to create event loop");
+            }
+            watch(listen_fd_, EPOLLIN, EPOLL_CTL_ADD);
+            watch(stop_fd_, EPOLLIN, EPOLL_CTL_ADD);
+        } catch (...) {
+            close_sockets();
+            throw;
+        }
+    }
+
+    QueryServer(const QueryServer& rhs) = delete;
+    QueryServer& operator=(const QueryServer& rhs) = delete;
+
+    ~QueryServer() noexcept {
+        close_sockets();
+    }
+
+    const string& path() const {
+        return path_;
+    }
+
+    /**
+     * @brief serve the connections until stop() is called
+     */
+    void run() {
+        epoll_event events[64];
+        while (true) {
+            int count = ::epoll_wait(epoll_fd_, events, 64, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                detail::throw_socket_error("unable to wait for events");
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == stop_fd_) {
+                    std::uint64_t value;
+                    ssize_t res = ::read(stop_fd_, &value, sizeof(value));
+                    static_cast<void>(res);
+                    close_all();
+                    return;
+                }
+                if (fd == listen_fd_) {
+                    accept_connections();
+                    continue;
+                }
+
+                auto it = connections_.find(fd);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                bool open;
+                try {
+                    open = serve(fd, it->second, events[i].events);
+                } catch (const std::exception&) {
+                    // a failure of one connection does not stop the others
+                    open = false;
+                }
+                if (!open) {
+                    close_connection(fd);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief make run() return, may be called from any thread
+     */
+    void stop() {
+        std::uint64_t value = 1;
+        ssize_t res = ::write(stop_fd_, &value, sizeof(value));
+        static_cast<void>(res);
+    }
+};
+
+/**
+ * @class QueryResponse
+ * @brief a response of the query server, the items hold the fields of the
+ * mask of the request and default values for the others
+ */
+template <typename Item>
+struct QueryResponse {
+    std::uint64_t id;
+    QueryOp op;
+    QueryStatus status;
+    string error;
+    // whether each key of a lookup is found, true for the rows of a scan
+    std::vector<bool> found;
+    std::vector<Item> items;
+};
+
+/**
+ * @class QueryClient
+ * @brief a blocking client of the query server, the requests can be sent
+ * ahead of their responses and several keys can be looked up per request
+ * @tparam Item the type of the items
+ * @tparam K the index of the key field
+ */
+template <typename Item, size_t K>
+class QueryClient {
+public:
+    using key_type = field_value_t<K, Item>;
+
+private:
+    int fd_;
+    std::uint64_t next_id_;
+    // the requests not sent yet
+    string out_;
+    string in_;
+
+    size_t begin_request(QueryOp op, std::uint64_t mask, std::uint64_t& id) {
+        id = next_id_++;
+        size_t frame = detail::begin_frame(out_);
+        write_unsigned(out_, id, 8);
+        write_unsigned(out_, static_cast<std::uint8_t>(op), 1);
+        write_unsigned(out_, mask, 8);
+        return frame;
+    }
+
+    void fill(size_t size) {
+        char buf[1 << 16];
+        while (in_.size() < size) {
+            ssize_t res = ::recv(fd_, buf, sizeof(buf), 0);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0) {
+                detail::throw_socket_error("unable to receive response");
+            }
+            if (res == 0) {
+                throw std::runtime_error("query server closed the connection");
+            }
+            in_.append(buf, static_cast<size_t>(res));
+        }
+    }
+
+public:
+    /**
+     * @brief connect to a server
+     * @param path the path of the socket of the server
+     */
+    explicit QueryClient(const string& path) : next_id_(1) {
+        sockaddr_un addr = detail::socket_address(path);
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            detail::throw_socket_error("unable to create socket");
+        }
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+            0) {
+            ::close(fd_);
+            detail::throw_socket_error(
+                fmt::format("unable to connect to {}", path));
+        }
+    }
+
+    QueryClient(const QueryClient& rhs) = delete;
+    QueryClient& operator=(const QueryClient& rhs) = delete;
+
+    ~QueryClient() noexcept {
+        ::close(fd_);
+    }
+
+    /**
+     * @brief queue a lookup of several keys
+     * @param keys the keys
+     * @param mask the fields to return
+     * @return the id of the request
+     */
+    std::uint64_t send_lookup(const std::vector<key_type>& keys,
+                              std::uint64_t mask = all_fields) {
+        std::uint64_t id;
+        size_t frame = begin_request(QueryOp::Lookup, mask, id);
+        write_unsigned(out_, keys.size(), 4);
+        for (const auto& key : keys) {
+            write_value(out_, key);
+        }
+        detail::end_frame(out_, frame);
+        return id;
+    }
+
+    /**
+     * @brief queue a scan of a range of keys
+     * @param first the first key
+     * @param last the last key, included
+     * @param limit the maximum count of rows
+     * @param mask the fields to return
+     * @return the id of the request
+     */
+    std::uint64_t send_scan(const key_type& first, const key_type& last,
+                            std::uint32_t limit = ~std::uint32_t(0),
+                            std::uint64_t mask = all_fields) {
+        std::uint64_t id;
+        size_t frame = begin_request(QueryOp::Scan, mask, id);
+        write_value(out_, first);
+        write_value(out_, last);
+        write_unsigned(out_, limit, 4);
+        detail::end_frame(out_, frame);
+        return id;
+    }
+
+    /**
+     * @brief send the queued requests in one write
+     */
+    void flush() {
+        size_t sent = 0;
+        while (sent < out_.size()) {
+            ssize_t res = ::send(fd_, out_.data() + sent, out_.size() - sent,
+                                 MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0) {
+                detail::throw_socket_error("unable to send request");
+            }
+            sent += static_cast<size_t>(res);
+        }
+        out_.clear();
+    }
+
+    /**
+     * @brief send the queued requests and close the sending side of the
+     * connection, the responses of the requests sent are still received
+     */
+    void finish() {
+        flush();
+        if (::shutdown(fd_, SHUT_WR) != 0) {
+            detail::throw_socket_error("unable to shut down connection");
+        }
+    }
+
+    /**
+     * @brief wait for the next response, the queued requests are sent first
+     * @return the response
+     */
+    QueryResponse<Item> receive() {
+        flush();
+        fill(4);
+        size_t length = static_cast<size_t>(BinaryReader(in_).read_unsigned(4));
+        fill(4 + length);
+
+        BinaryReader reader(in_.data() + 4, length);
+        QueryResponse<Item> res;
+        res.id = reader.read_unsigned(8);
+        res.op = static_cast<QueryOp>(reader.read_unsigned(1));
+        res.status = static_cast<QueryStatus>(reader.read_unsigned(1));
+        std::uint64_t mask = reader.read_unsigned(8);
+        if (res.status != QueryStatus::Ok) {
+            reader.read_value(res.error);
+        } else {
+            size_t count = static_cast<size_t>(reader.read_unsigned(4));
+            res.found.reserve(count);
+            res.items.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                bool found = true;
+                if (res.op == QueryOp::Lookup) {
+                    reader.read_value(found);
+                }
+                if (found) {
+                    read_item(reader, res.items[i], mask);
+                }
+                res.found.push_back(found);
+            }
+        }
+        in_.erase(0, 4 + length);
+        return res;
+    }
+
+    /**
+     * @brief look up several keys in one round trip
+     * @param keys the keys
+     * @param mask the fields to return
+     * @return the response
+     */
+    QueryResponse<Item> lookup(const std::vector<key_type>& keys,
+                               std::uint64_t mask = all_fields) {
+        send_lookup(keys, mask);
+        return receive();
+    }
+
+    /**
+     * @brief scan a range of keys
+     * @param first the first key
+     * @param last the last key, included
+     * @param limit the maximum count of rows
+     * @param mask the fields to return
+     * @return the response
+     */
+    QueryResponse<Item> scan(const key_type& first, const key_type& last,
+                             std::uint32_t limit = ~std::uint32_t(0),
+                             std::uint64_t mask = all_fields) {
+        send_scan(first, last, limit, mask);
+        return receive();
+    }
+};
+} // namespace msf
+#endif
@@ -0,0 +1,375 @@
+#ifndef PMS_RESULTSET_HPP
+#define PMS_RESULTSET_HPP
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <msf/sort.hpp>
+#include <msf/types.hpp>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @class ResultSet
+ * @brief a view of some rows of a collection, the rows are ordered only as
+ * far as the requested pages reach and formatted only when they are on a
+ * requested page
+ * @tparam Item the type of the items
+ */
+template <typename Item>
+class ResultSet {
+public:
+    using str_array = typename Item::str_array;
+
+    static constexpr size_t default_cache_capacity = 256;
+
+private:
+    /**
+     * @class Ordering
+     * @brief the state of an ordering in progress over the rows after the
+     * ordered prefix
+     */
+    struct Ordering {
+        virtual ~Ordering() = default;
+
+        /**
+         * @brief take the next rows in order
+         * @param count the count of rows, at most the count of the rows left
+         * @param out the array to receive the indices of the rows
+         */
+        virtual void next(size_t count, size_t* out) = 0;
+
+        /**
+         * @brief get the rows not taken yet
+         * @param out the array to receive the indices of the rows in their
+         * order before the ordering began
+         */
+        virtual void remaining(size_t* out) const = 0;
+    };
+
+    /**
+     * @class KeyOrdering
+     * @brief an ordering by some fields, the keys are encoded once into a
+     * heap which every page pops its rows from
+     * @tparam Ns the indices of the key fields, the most significant first
+     */
+    template <size_t... Ns>
+    class KeyOrdering : public Ordering {
+    private:
+        // the rows when the ordering began, the keys refer to them
+        std::vector<size_t> rows_;
+        detail::SortKeys<Item, Ns...> keys_;
+        // the positions in rows_ of the rows not taken yet
+        std::vector<size_t> heap_;
+
+        // the positions break the ties to keep the order stable, the heap
+        // keeps the smallest on top
+        bool after(size_t lhs, size_t rhs) const {
+            int res = keys_.compare(lhs, rhs);
+            return res > 0 || (res == 0 && lhs > rhs);
+        }
+
+    public:
+        KeyOrdering(const std::vector<Item>& items, std::vector<size_t> rows,
+                    SortOrder order)
+            : rows_(std::move(rows)), keys_(items, rows_, order),
+              heap_(rows_.size()) {
+            std::iota(heap_.begin(), heap_.end(), 0);
+            std::make_heap(heap_.begin(), heap_.end(),
+                           [this](size_t lhs, size_t rhs) {
+                               return after(lhs, rhs);
+                           });
+        }
+
+        void next(size_t count, size_t* out) override {
+            auto after = [this](size_t lhs, size_t rhs) {
+                return this->after(lhs, rhs);
+            };
+            for (size_t i = 0; i < count; ++i) {
+                std::pop_heap(heap_.begin(), heap_.end(), after);
+                out[i] = rows_[heap_.back()];
+                heap_.pop_back();
+            }
+        }
+
+        void remaining(size_t* out) const override {
+            std::vector<size_t> positions(heap_);
+            std::sort(positions.begin(), positions.end());
+            for (size_t i = 0; i < positions.size(); ++i) {
+                out[i] = rows_[positions[i]];
+            }
+        }
+    };
+
+    // the function starting an ordering over some rows
+    using ordering_maker = std::unique_ptr<Ordering> (*)(
+        const std::vector<Item>&, std::vector<size_t>, SortOrder);
+
+    struct CacheEntry {
+        str_array strs;
+        std::list<size_t>::iterator position;
+    };
+
+    const std::vector<Item>* items_;
+    // the indices of the rows in the collection, the rows after the ordered
+    // prefix are held by the ordering in progress if there is one
+    std::vector<size_t> rows_;
+    // the count of the rows at the front of rows_ in their final order
+    size_t sorted_prefix_;
+    ordering_maker make_ordering_;
+    SortOrder order_;
+    std::unique_ptr<Ordering> ordering_;
+
+    // the formatted rows by index in the collection, the most recent first
+    size_t cache_capacity_;
+    std::unordered_map<size_t, CacheEntry> cache_;
+    std::list<size_t> recent_;
+    size_t formatted_rows_;
+
+    template <size_t... Ns>
+    static std::unique_ptr<Ordering>
+    start_ordering(const std::vector<Item>& items, std::vector<size_t> rows,
+                   SortOrder order) {
+        return std::unique_ptr<Ordering>(
+            new KeyOrdering<Ns...>(items, std::move(rows), order));
+    }
+
+    template <size_t... Is>
+    static ordering_maker maker_of(size_t field, std::index_sequence<Is...>) {
+        static const ordering_maker makers[] = {
+            &ResultSet::start_ordering<Is>...};
+        return makers[field];
+    }
+
+    /**
+     * @brief make sure the first k rows are in their final order, the keys
+     * of the rows after the ordered prefix are encoded by the first call and
+     * every later call only pops the rows it needs
+     * @param k the count of rows
+     */
+    void ensure_sorted(size_t k) {
+        k = std::min(k, rows_.size());
+        if (make_ordering_ == nullptr || k <= sorted_prefix_) {
+            return;
+        }
+        if (ordering_ == nullptr) {
+            ordering_ = make_ordering_(
+                *items_,
+                std::vector<size_t>(rows_.begin() + sorted_prefix_,
+                                    rows_.end()),
+                order_);
+        }
+        ordering_->next(k - sorted_prefix_, rows_.data() + sorted_prefix_);
+        sorted_prefix_ = k;
+    }
+
+    /**
+     * @brief put the rows held by the ordering in progress back after the
+     * ordered prefix
+     */
+    void release_ordering() {
+        if (ordering_ != nullptr) {
+            ordering_->remaining(rows_.data() + sorted_prefix_);
+            ordering_.reset();
+        }
+    }
+
+    const str_array& format(size_t row) {
+        auto it = cache_.find(row);
+        if (it != cache_.end()) {
+            recent_.splice(recent_.begin(), recent_, it->second.position);
+            return it->second.strs;
+        }
+
+        if (cache_.size() >= cache_capacity_) {
+            cache_.erase(recent_.back());
+            recent_.pop_back();
+        }
+        recent_.push_front(row);
+        ++formatted_rows_;
+        CacheEntry& entry = cache_[row];
+        entry.strs = (*items_)[row].get_field_strs();
+        entry.position = recent_.begin();
+        return entry.strs;
+    }
+
+public:
+    /**
+     * @brief create a result set of all the rows of a collection, the
+     * collection must outlive the result set
+     * @param items the collection
+     * @param cache_capacity the count of formatted rows kept
+     */
+    explicit ResultSet(const std::vector<Item>& items,
+                       size_t cache_capacity = default_cache_capacity)
+        : ResultSet(items, std::vector<size_t>(items.size()), cache_capacity) {
+        std::iota(rows_.begin(), rows_.end(), 0);
+    }
+
+    /**
+     * @brief create a result set of some rows of a collection, the collection
+     * must outlive the result set
+     * @param items the collection
+     * @param rows the indices of the rows in the collection
+     * @param cache_capacity the count of formatted rows kept
+     */
+    ResultSet(const std::vector<Item>& items, std::vector<size_t> rows,
+              size_t cache_capacity = default_cache_capacity)
+        : items_(&items), rows_(std::move(rows)), sorted_prefix_(0),
+          make_ordering_(nullptr), order_(SortOrder::Ascending),
+          cache_capacity_(std::max<size_t>(cache_capacity, 1)),
+          formatted_rows_(0) {}
+
+    /**
+     * @brief copy the rows and the order, the ordering in progress and the
+     * cache are not copied
+     * @param rhs the other result set
+     */
+    ResultSet(const ResultSet& rhs)
+        : items_(rhs.items_), rows_(rhs.rows_),
+          sorted_prefix_(rhs.sorted_prefix_),
+          make_ordering_(rhs.make_ordering_), order_(rhs.order_),
+          cache_capacity_(rhs.cache_capacity_), formatted_rows_(0) {
+        if (rhs.ordering_ != nullptr) {
+            rhs.ordering_->remaining(rows_.data() + sorted_prefix_);
+        }
+    }
+    ResultSet(ResultSet&& rhs) noexcept = default;
+    ~ResultSet() noexcept = default;
+
+    ResultSet& operator=(const ResultSet& rhs) {
+        if (this != &rhs) {
+            *this = ResultSet(rhs);
+        }
+        return *this;
+    }
+    ResultSet& operator=(ResultSet&& rhs) noexcept = default;
+
+    /**
+     * @brief keep the rows matching a predicate, nothing is formatted
+     * @param pred the predicate called with the items
+     * @return the reference of the result set
+     */
+    template <typename Pred>
+    ResultSet& where(Pred pred) {
+        release_ordering();
+        const auto& items = *items_;
+        auto rejected = [&](size_t row) { return !pred(items[row]); };
+        rows_.erase(std::remove_if(rows_.begin(), rows_.end(), rejected),
+                    rows_.end());
+        sorted_prefix_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief order the rows by some fields, the sort is deferred until a page
+     * is requested
+     * @tparam Ns the indices of the key fields, the most significant first
+     * @param order the order of the sort
+     * @return the reference of the result set
+     */
+    template <size_t... Ns>
+    ResultSet& order_by(SortOrder order = SortOrder::Ascending) {
+        release_ordering();
+        make_ordering_ = &ResultSet::start_ordering<Ns...>;
+        order_ = order;
+        sorted_prefix_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief order the rows by a field chosen at runtime, the sort is deferred
+     * until a page is requested
+     * @param field the index of the field
+     * @param order the order of the sort
+     * @return the reference of the result set
+     */
+    ResultSet& order_by(size_t field, SortOrder order = SortOrder::Ascending) {
+        if (field >= Item::get_field_count()) {
+            throw std::out_of_range("field index out of range");
+        }
+        release_ordering();
+        make_ordering_ = maker_of(
+            field, std::make_index_sequence<Item::get_field_count()>());
+        order_ = order;
+        sorted_prefix_ = 0;
+        return *this;
+    }
+
+    /**
+     * @brief get the count of the rows
+     * @return the count of the rows
+     */
+    size_t size() const {
+        return rows_.size();
+    }
+
+    /**
+     * @brief get the index in the collection of the row at a position
+     * @param pos the position of the row in the result set
+     * @return the index of the row in the collection
+     */
+    size_t row(size_t pos) {
+        if (pos >= rows_.size()) {
+            throw std::out_of_range("result set position out of range");
+        }
+        ensure_sorted(pos + 1);
+        return rows_[pos];
+    }
+
+    /**
+     * @brief get the item at a position
+     * @param pos the position of the row in the result set
+     * @return the const reference of the item
+     */
+    const Item& item(size_t pos) {
+        return (*items_)[row(pos)];
+    }
+
+    /**
+     * @brief get the indices in the collection of the rows of a page, only
+     * the rows up to the end of the page are ordered
+     * @param offset the position of the first row of the page
+     * @param limit the maximum count of rows of the page
+     * @return the indices of the rows in the collection
+     */
+    std::vector<size_t> page_rows(size_t offset, size_t limit) {
+        offset = std::min(offset, rows_.size());
+        size_t end = offset + std::min(limit, rows_.size() - offset);
+        ensure_sorted(end);
+        return std::vector<size_t>(rows_.begin() + offset,
+                                   rows_.begin() + end);
+    }
+
+    /**
+     * @brief get the fields' values in string format of the rows of a page,
+     * only the rows of the page are formatted and they are cached for later
+     * requests
+     * @param offset the position of the first row of the page
+     * @param limit the maximum count of rows of the page
+     * @return the string arrays of the rows
+     */
+    std::vector<str_array> page(size_t offset, size_t limit) {
+        std::vector<str_array> res;
+        for (auto row : page_rows(offset, limit)) {
+            res.push_back(format(row));
+        }
+        return res;
+    }
+
+    /**
+     * @brief get the count of rows formatted so far, the cached rows are not
+     * formatted again
+     * @return the count of formatted rows
+     */
+    size_t formatted_rows() const {
+        return formatted_rows_;
+    }
+};
+} // namespace msf
+#endif
@@ -0,0 +1,381 @@
+#ifndef PMS_TEXTINDEX_HPP
+#define PMS_TEXTINDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <msf/BasicItem.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @class TextIndex
+ * @brief an index over a text field of the rows of a collection, answering
+ * prefix queries from the values in sorted order and substring queries from
+ * the posting lists of the trigrams of the values
+ * @tparam Item the type of the items
+ * @tparam N the index of the text field
+ */
+template <typename Item, size_t N>
+class TextIndex {
+    static_assert(std::is_same<field_t<N, Item>, TextField>::value,
+                  "the indexed field must be a TextField");
+
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    // the value of a row and the row, the values are owned by values_
+    using Entry = std::pair<const string*, size_t>;
+    using entry_iterator = typename std::vector<Entry>::const_iterator;
+
+    // the pending entries are merged into the sorted ones and the removed
+    // entries purged from them once they reach max_pending together, an
+    // insertion or a removal shifts at most max_pending entries and a merge
+    // happens every max_pending changes
+    static constexpr size_t max_pending = 256;
+
+    std::unordered_map<size_t, std::unique_ptr<const string>> values_;
+    // the entries in the order of value and row, the recent insertions are
+    // kept apart so an insertion does not shift the whole index
+    std::vector<Entry> sorted_;
+    std::vector<Entry> pending_;
+    // the values of the entries removed from sorted_ in the order of their
+    // addresses, the entries are skipped until the next merge
+    std::vector<std::unique_ptr<const string>> removed_;
+    // the rows in ascending order by trigram
+    std::unordered_map<std::uint32_t, std::vector<size_t>> postings_;
+
+    static std::uint32_t trigram(const string& value, size_t pos) {
+        return static_cast<std::uint32_t>(
+            static_cast<unsigned char>(value[pos]) |
+            static_cast<unsigned char>(value[pos + 1]) << 8 |
+            static_cast<unsigned char>(value[pos + 2]) << 16);
+    }
+
+    static std::vector<std::uint32_t> trigrams(const string& value) {
+        std::vector<std::uint32_t> res;
+        for (size_t pos = 0; pos + 3 <= value.size(); ++pos) {
+            res.push_back(trigram(value, pos));
+        }
+        std::sort(res.begin(), res.end());
+        res.erase(std::unique(res.begin(), res.end()), res.end());
+        return res;
+    }
+
+    static bool starts_with(const string& value, const string& prefix) {
+        return value.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    static bool entry_less(const Entry& lhs, const Entry& rhs) {
+        int res = lhs.first->compare(*rhs.first);
+        return res < 0 || (res == 0 && lhs.second < rhs.second);
+    }
+
+    static bool removed_less(const std::unique_ptr<const string>& lhs,
+                             const string* rhs) {
+        return std::less<const string*>()(lhs.get(), rhs);
+    }
+
+    bool is_removed(const string* value) const {
+        auto it = std::lower_bound(removed_.begin(), removed_.end(), value,
+                                   removed_less);
+        return it != removed_.end() && it->get() == value;
+    }
+
+    void merge_pending() {
+        if (!removed_.empty()) {
+            sorted_.erase(std::remove_if(sorted_.begin(), sorted_.end(),
+                                         [this](const Entry& entry) {
+                                             return is_removed(entry.first);
+                                         }),
+                          sorted_.end());
+            removed_.clear();
+        }
+        size_t middle = sorted_.size();
+        sorted_.insert(sorted_.end(), pending_.begin(), pending_.end());
+        std::inplace_merge(sorted_.begin(), sorted_.begin() + middle,
+                           sorted_.end(), entry_less);
+        pending_.clear();
+    }
+
+    void add(size_t row, const string& value) {
+        const string* stored =
+            values_.emplace(row, std::unique_ptr<const string>(
+                                     new string(value)))
+                .first->second.get();
+        Entry entry(stored, row);
+        pending_.insert(std::lower_bound(pending_.begin(), pending_.end(),
+                                         entry, entry_less),
+                        entry);
+        if (pending_.size() + removed_.size() >= max_pending) {
+            merge_pending();
+        }
+        for (auto gram : trigrams(value)) {
+            auto& posting = postings_[gram];
+            // the rows are mostly inserted in ascending order
+            if (posting.empty() || posting.back() < row) {
+                posting.push_back(row);
+            } else {
+                posting.insert(
+                    std::lower_bound(posting.begin(), posting.end(), row),
+                    row);
+            }
+        }
+    }
+
+    /**
+     * @brief remove the value of a row, an entry still pending is dropped
+     * and a sorted one is only marked as removed
+     */
+    void remove(typename decltype(values_)::iterator it) {
+        size_t row = it->first;
+        const string* value = it->second.get();
+        for (auto gram : trigrams(*value)) {
+            auto posting_it = postings_.find(gram);
+            auto& posting = posting_it->second;
+            posting.erase(
+                std::lower_bound(posting.begin(), posting.end(), row));
+            if (posting.empty()) {
+                postings_.erase(posting_it);
+            }
+        }
+
+        Entry entry(value, row);
+        auto pending = std::lower_bound(pending_.begin(), pending_.end(),
+                                        entry, entry_less);
+        if (pending != pending_.end() && pending->first == value) {
+            pending_.erase(pending);
+        } else {
+            removed_.insert(std::lower_bound(removed_.begin(), removed_.end(),
+                                             value, removed_less),
+                            std::move(it->second));
+        }
+        values_.erase(it);
+        if (pending_.size() + removed_.size() >= max_pending) {
+            merge_pending();
+        }
+    }
+
+    static entry_iterator first_prefixed(const std::vector<Entry>& entries,
+                                         const string& prefix) {
+        return std::lower_bound(
+            entries.begin(), entries.end(), prefix,
+            [](const Entry& entry, const string& value) {
+                return *entry.first < value;
+            });
+    }
+
+    /**
+     * @brief skip the removed entries of sorted_
+     */
+    entry_iterator next_live(entry_iterator it) const {
+        if (!removed_.empty()) {
+            while (it != sorted_.end() && is_removed(it->first)) {
+                ++it;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * @brief copy the live entries of another index, the values are copied
+     * so the entries point to the values of this index
+     */
+    void copy_entries(const TextIndex& rhs) {
+        for (const auto& value : rhs.values_) {
+            values_.emplace(value.first, std::unique_ptr<const string>(
+                                             new string(*value.second)));
+        }
+        auto own = [this](const Entry& entry) {
+            return Entry(values_.at(entry.second).get(), entry.second);
+        };
+        sorted_.reserve(rhs.sorted_.size() - rhs.removed_.size());
+        for (auto it = rhs.next_live(rhs.sorted_.begin());
+             it != rhs.sorted_.end(); it = rhs.next_live(it + 1)) {
+            sorted_.push_back(own(*it));
+        }
+        for (const auto& entry : rhs.pending_) {
+            pending_.push_back(own(entry));
+        }
+    }
+
+public:
+    TextIndex() = default;
+
+    /**
+     * @brief index every row of a collection
+     * @param items the items, the rows are their indices
+     */
+    explicit TextIndex(const std::vector<Item>& items) {
+        sorted_.reserve(items.size());
+        for (size_t row = 0; row < items.size(); ++row) {
+            const string& value = items[row].template get_field_value<N>();
+            const string* stored =
+                values_.emplace(row, std::unique_ptr<const string>(
+                                         new string(value)))
+                    .first->second.get();
+            sorted_.emplace_back(stored, row);
+            for (auto gram : trigrams(value)) {
+                postings_[gram].push_back(row);
+            }
+        }
+        std::sort(sorted_.begin(), sorted_.end(), entry_less);
+    }
+
+    TextIndex(const TextIndex& rhs) : postings_(rhs.postings_) {
+        copy_entries(rhs);
+    }
+
+    TextIndex(TextIndex&& rhs) noexcept = default;
+    ~TextIndex() noexcept = default;
+
+    TextIndex& operator=(const TextIndex& rhs) {
+        if (this != &rhs) {
+            TextIndex copy(rhs);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    TextIndex& operator=(TextIndex&& rhs) noexcept = default;
+
+    /**
+     * @brief index a row, replacing its value if the row is indexed already
+     * @param row the row
+     * @param item the item of the row
+     */
+    void insert(size_t row, const Item& item) {
+        update(row, item);
+    }
+
+    /**
+     * @brief remove a row from the index
+     * @param row the row
+     * @return false if the row is not indexed
+     */
+    bool erase(size_t row) {
+        auto it = values_.find(row);
+        if (it == values_.end()) {
+            return false;
+        }
+        remove(it);
+        return true;
+    }
+
+    /**
+     * @brief reindex a row after its item changed, nothing is done if the
+     * value of the field is unchanged
+     * @param row the row
+     * @param item the item of the row
+     */
+    void update(size_t row, const Item& item) {
+        const string& value = item.template get_field_value<N>();
+        auto it = values_.find(row);
+        if (it != values_.end()) {
+            if (*it->second == value) {
+                return;
+            }
+            remove(it);
+        }
+        add(row, value);
+    }
+
+    bool contains(size_t row) const {
+        return values_.count(row) != 0;
+    }
+
+    size_t size() const {
+        return values_.size();
+    }
+
+    /**
+     * @brief find the rows whose value starts with a prefix, the sorted and
+     * the pending entries are merged as they are walked so only the first
+     * limit matches are looked at
+     * @param prefix the prefix
+     * @param limit the maximum count of rows
+     * @return the rows in the order of their values
+     */
+    std::vector<size_t> find_prefix(const string& prefix,
+                                    size_t limit = npos) const {
+        std::vector<size_t> res;
+        auto sorted = next_live(first_prefixed(sorted_, prefix));
+        auto pending = first_prefixed(pending_, prefix);
+        bool in_sorted =
+            sorted != sorted_.end() && starts_with(*sorted->first, prefix);
+        bool in_pending = pending != pending_.end() &&
+            starts_with(*pending->first, prefix);
+        while (res.size() < limit && (in_sorted || in_pending)) {
+            if (in_sorted && (!in_pending || entry_less(*sorted, *pending))) {
+                res.push_back(sorted->second);
+                sorted = next_live(sorted + 1);
+                in_sorted = sorted != sorted_.end() &&
+                    starts_with(*sorted->first, prefix);
+            } else {
+                res.push_back(pending->second);
+                ++pending;
+                in_pending = pending != pending_.end() &&
+                    starts_with(*pending->first, prefix);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief find the rows whose value contains a pattern, the candidates are
+     * the rows holding every trigram of the pattern and are verified against
+     * their values, the patterns shorter than a trigram scan every row
+     * @param pattern the pattern
+     * @return the rows in ascending order
+     */
+    std::vector<size_t> find_substring(const string& pattern) const {
+        std::vector<size_t> res;
+        if (pattern.size() < 3) {
+            for (const auto& value : values_) {
+                if (value.second->find(pattern) != string::npos) {
+                    res.push_back(value.first);
+                }
+            }
+            std::sort(res.begin(), res.end());
+            return res;
+        }
+
+        std::vector<const std::vector<size_t>*> lists;
+        for (auto gram : trigrams(pattern)) {
+            auto it = postings_.find(gram);
+            if (it == postings_.end()) {
+                return res;
+            }
+            lists.push_back(&it->second);
+        }
+        // intersect from the shortest list
+        std::sort(lists.begin(), lists.end(),
+                  [](const auto* lhs, const auto* rhs) {
+                      return lhs->size() < rhs->size();
+                  });
+        for (auto row : *lists.front()) {
+            bool candidate = true;
+            for (size_t i = 1; candidate && i < lists.size(); ++i) {
+                candidate = std::binary_search(lists[i]->begin(),
+                                               lists[i]->end(), row);
+            }
+            // a pattern of one trigram needs no verification
+            if (candidate &&
+                (pattern.size() == 3 ||
+                 values_.at(row)->find(pattern) != string::npos)) {
+                res.push_back(row);
+            }
+        }
+        return res;
+    }
+};
+} // namespace msf
+#endif
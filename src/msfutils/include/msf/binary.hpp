@@ -0,0 +1,249 @@
+#ifndef PMS_BINARY_HPP
+#define PMS_BINARY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fmt/format.h>
+#include <msf/DateTime.hpp>
+#include <msf/types.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace msf {
+
+/**
+ * @brief append an unsigned integer in little-endian order
+ * @param out the buffer
+ * @param value the value
+ * @param bytes the count of bytes to write
+ */
+inline void write_unsigned(string& out, std::uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+inline void write_value(string& out, Integer value) {
+    write_unsigned(out, static_cast<std::uint64_t>(value), 8);
+}
+
+inline void write_value(string& out, bool value) {
+    out.push_back(value ? 1 : 0);
+}
+
+inline void write_value(string& out, double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write_unsigned(out, bits, 8);
+}
+
+/**
+ * @brief append a string after its length in 4 bytes
+ * @param out the buffer
+ * @param value the string, std::length_error is thrown from 4 GiB on
+ */
+inline void write_value(string& out, const string& value) {
+    if (value.size() > UINT32_MAX) {
+        throw std::length_error(fmt::format(
+            "string of {} bytes is too long to be written", value.size()));
+    }
+    write_unsigned(out, value.size(), 4);
+    out.append(value);
+}
+
+inline void write_value(string& out, const Date& value) {
+    write_value(out, value.year);
+    write_value(out, value.month);
+    write_value(out, value.day);
+}
+
+inline void write_value(string& out, const Time& value) {
+    write_value(out, value.hour);
+    write_value(out, value.minute);
+    write_value(out, value.second);
+}
+
+inline void write_value(string& out, const DateTime& value) {
+    write_value(out, static_cast<const Date&>(value));
+    write_value(out, static_cast<const Time&>(value));
+}
+
+/**
+ * @class BinaryReader
+ * @brief the reader of the values written by write_value(), it throws
+ * std::runtime_error when the data is truncated
+ */
+class BinaryReader {
+private:
+    const char* pos_;
+    const char* end_;
+
+    const char* take(size_t bytes) {
+        if (static_cast<size_t>(end_ - pos_) < bytes) {
+            throw std::runtime_error(
+                fmt::format("truncated binary data, {} bytes expected but {} "
+                            "bytes left",
+                            bytes, end_ - pos_));
+        }
+        const char* res = pos_;
+        pos_ += bytes;
+        return res;
+    }
+
+public:
+    BinaryReader(const char* data, size_t size)
+        : pos_(data), end_(data + size) {}
+
+    explicit BinaryReader(const string& data)
+        : BinaryReader(data.data(), data.size()) {}
+
+    /**
+     * @brief get the count of the bytes not read yet
+     * @return the count of bytes
+     */
+    size_t remaining() const {
+        return end_ - pos_;
+    }
+
+    /**
+     * @brief read an unsigned integer in little-endian order
+     * @param bytes the count of bytes to read
+     * @return the value
+     */
+    std::uint64_t read_unsigned(size_t bytes) {
+        const unsigned char* p =
+            reinterpret_cast<const unsigned char*>(take(bytes));
+        std::uint64_t res = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            res |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        }
+        return res;
+    }
+
+    void read_value(Integer& value) {
+        value = static_cast<Integer>(read_unsigned(8));
+    }
+
+    void read_value(bool& value) {
+        value = *take(1) != 0;
+    }
+
+    void read_value(double& value) {
+        std::uint64_t bits = read_unsigned(8);
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+
+    void read_value(string& value) {
+        size_t size = static_cast<size_t>(read_unsigned(4));
+        value.assign(take(size), size);
+    }
+
+    void read_value(Date& value) {
+        read_value(value.year);
+        read_value(value.month);
+        read_value(value.day);
+    }
+
+    void read_value(Time& value) {
+        read_value(value.hour);
+        read_value(value.minute);
+        read_value(value.second);
+    }
+
+    void read_value(DateTime& value) {
+        read_value(static_cast<Date&>(value));
+        read_value(static_cast<Time&>(value));
+    }
+};
+
+namespace detail {
+
+template <typename Item, size_t... Is>
+void write_fields(string& out, const Item& item, std::index_sequence<Is...>) {
+    int order[] = {0, (write_value(out, item.template get_field_value<Is>()),
+                       0)...};
+    static_cast<void>(order);
+}
+
+template <typename Item, size_t... Is>
+void read_fields(BinaryReader& reader, Item& item,
+                 std::index_sequence<Is...>) {
+    int order[] = {
+        0, (reader.read_value(item.template get_field_value<Is>()), 0)...};
+    static_cast<void>(order);
+}
+
+template <typename Item, size_t... Is>
+void write_fields(string& out, const Item& item, std::uint64_t field_mask,
+                  std::index_sequence<Is...>) {
+    int order[] = {
+        0, ((field_mask >> Is & 1)
+                ? (write_value(out, item.template get_field_value<Is>()), 0)
+                : 0)...};
+    static_cast<void>(order);
+}
+
+template <typename Item, size_t... Is>
+void read_fields(BinaryReader& reader, Item& item, std::uint64_t field_mask,
+                 std::index_sequence<Is...>) {
+    int order[] = {
+        0, ((field_mask >> Is & 1)
+                ? (reader.read_value(item.template get_field_value<Is>()), 0)
+                : 0)...};
+    static_cast<void>(order);
+}
+} // namespace detail
+
+/**
+ * @brief append the typed values of every field of an item
+ * @param out the buffer
+ * @param item the item
+ */
+template <typename Item>
+void write_item(string& out, const Item& item) {
+    detail::write_fields(
+        out, item, std::make_index_sequence<Item::get_field_count()>());
+}
+
+/**
+ * @brief read the values of every field of an item written by write_item()
+ * @param reader the reader
+ * @param item the item to receive the values
+ */
+template <typename Item>
+void read_item(BinaryReader& reader, Item& item) {
+    detail::read_fields(reader, item,
+                        std::make_index_sequence<Item::get_field_count()>());
+}
+
+/**
+ * @brief append the typed values of some fields of an item
+ * @param out the buffer
+ * @param item the item
+ * @param field_mask the bit i is set to write the field i
+ */
+template <typename Item>
+void write_item(string& out, const Item& item, std::uint64_t field_mask) {
+    static_assert(Item::get_field_count() <= 64,
+                  "the field mask covers at most 64 fields");
+    detail::write_fields(
+        out, item, field_mask,
+        std::make_index_sequence<Item::get_field_count()>());
+}
+
+/**
+ * @brief read the values of some fields of an item written by write_item(),
+ * the other fields are left unchanged
+ * @param reader the reader
+ * @param item the item to receive the values
+ * @param field_mask the mask the fields were written with
+ */
+template <typename Item>
+void read_item(BinaryReader& reader, Item& item, std::uint64_t field_mask) {
+    static_assert(Item::get_field_count() <= 64,
+                  "the field mask covers at most 64 fields");
+    detail::read_fields(reader, item, field_mask,
+                        std::make_index_sequence<Item::get_field_count()>());
+}
+} // namespace msf
+#endif
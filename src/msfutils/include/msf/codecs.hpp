@@ -0,0 +1,803 @@
+#ifndef PMS_CODECS_HPP
+#define PMS_CODECS_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <msf/BasicItem.hpp>
+#include <msf/DateTime.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace msf {
+
+namespace detail {
+
+/**
+ * @brief get the count of bits needed to represent a value
+ * @param value the value
+ * @return the count of bits, 0 for 0
+ */
+inline unsigned bit_width(std::uint64_t value) {
+    unsigned width = 0;
+    while (value != 0) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+/**
+ * @brief get the index of the lowest set bit of a non-zero word
+ * @param word the word
+ * @return the index of the lowest set bit
+ */
+inline unsigned count_trailing_zeros(std::uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned count = 0;
+    while ((word & 1) == 0) {
+        ++count;
+        word >>= 1;
+    }
+    return count;
+#endif
+}
+
+/**
+ * @brief write the low bits of a value at a bit position, the words must be
+ * zero-initialized
+ * @param words the packed words
+ * @param pos the bit position
+ * @param bits the count of bits to write
+ * @param value the value
+ */
+inline void pack_bits(std::uint64_t* words, size_t pos, unsigned bits,
+                      std::uint64_t value) {
+    if (bits == 0) {
+        return;
+    }
+    size_t word = pos / 64;
+    unsigned offset = pos % 64;
+    words[word] |= value << offset;
+    if (offset + bits > 64) {
+        words[word + 1] |= value >> (64 - offset);
+    }
+}
+
+/**
+ * @brief read a value of the given width at a bit position
+ * @param words the packed words
+ * @param pos the bit position
+ * @param bits the count of bits to read
+ * @return the value
+ */
+inline std::uint64_t unpack_bits(const std::uint64_t* words, size_t pos,
+                                 unsigned bits) {
+    if (bits == 0) {
+        return 0;
+    }
+    size_t word = pos / 64;
+    unsigned offset = pos % 64;
+    std::uint64_t value = words[word] >> offset;
+    if (offset + bits > 64) {
+        value |= words[word + 1] << (64 - offset);
+    }
+    return bits == 64 ? value : value & ((std::uint64_t(1) << bits) - 1);
+}
+
+inline std::uint64_t zigzag_encode(std::uint64_t delta) {
+    return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+inline std::uint64_t zigzag_decode(std::uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+} // namespace detail
+
+/**
+ * @brief the encodings an IntegerColumn chooses from for every block
+ */
+enum class IntegerEncoding : std::uint8_t {
+    // the offsets from the minimum of the block
+    FrameOfReference,
+    // the zigzag-encoded differences between neighbours
+    Delta
+};
+
+/**
+ * @class IntegerColumn
+ * @brief a column of integers compressed by blocks, each block keeps its
+ * minimum and maximum and is bit-packed with frame-of-reference or delta
+ * encoding, whichever is smaller
+ */
+class IntegerColumn {
+public:
+    static constexpr size_t default_block_size = 128;
+
+private:
+    struct Block {
+        Integer min;
+        Integer max;
+        // the minimum for frame-of-reference, the first value for delta
+        Integer reference;
+        size_t bit_offset;
+        unsigned bits;
+        IntegerEncoding encoding;
+    };
+
+    size_t block_size_;
+    size_t size_;
+    std::vector<Block> blocks_;
+    std::vector<std::uint64_t> words_;
+
+    void encode_block(const Integer* values, size_t count, size_t& bit_pos) {
+        Block block;
+        block.min = *std::min_element(values, values + count);
+        block.max = *std::max_element(values, values + count);
+
+        std::uint64_t range = static_cast<std::uint64_t>(block.max) -
+            static_cast<std::uint64_t>(block.min);
+        std::uint64_t delta_bits = 0;
+        for (size_t i = 1; i < count; ++i) {
+            delta_bits |= detail::zigzag_encode(
+                static_cast<std::uint64_t>(values[i]) -
+                static_cast<std::uint64_t>(values[i - 1]));
+        }
+        unsigned for_width = detail::bit_width(range);
+        unsigned delta_width = detail::bit_width(delta_bits);
+
+        // delta packs one value less, the first is the reference
+        if (delta_width * (count - 1) < for_width * count) {
+            block.encoding = IntegerEncoding::Delta;
+            block.reference = values[0];
+            block.bits = delta_width;
+        } else {
+            block.encoding = IntegerEncoding::FrameOfReference;
+            block.reference = block.min;
+            block.bits = for_width;
+        }
+        block.bit_offset = bit_pos;
+
+        size_t packed = block.encoding == IntegerEncoding::Delta ? count - 1
+                                                                : count;
+        words_.resize((bit_pos + packed * block.bits + 63) / 64 + 1, 0);
+        for (size_t i = 0; i < packed; ++i) {
+            std::uint64_t value;
+            if (block.encoding == IntegerEncoding::Delta) {
+                value = detail::zigzag_encode(
+                    static_cast<std::uint64_t>(values[i + 1]) -
+                    static_cast<std::uint64_t>(values[i]));
+            } else {
+                value = static_cast<std::uint64_t>(values[i]) -
+                    static_cast<std::uint64_t>(block.min);
+            }
+            detail::pack_bits(words_.data(), bit_pos, block.bits, value);
+            bit_pos += block.bits;
+        }
+        blocks_.push_back(block);
+    }
+
+public:
+    explicit IntegerColumn(size_t block_size = default_block_size)
+        : block_size_(block_size), size_(0) {
+        if (block_size_ == 0) {
+            throw std::invalid_argument("block size must be positive");
+        }
+    }
+
+    /**
+     * @brief compress the values
+     * @param values the values to compress
+     * @param block_size the count of values per block
+     */
+    explicit IntegerColumn(const std::vector<Integer>& values,
+                           size_t block_size = default_block_size)
+        : IntegerColumn(block_size) {
+        size_ = values.size();
+        size_t bit_pos = 0;
+        for (size_t first = 0; first < size_; first += block_size_) {
+            encode_block(values.data() + first,
+                         std::min(block_size_, size_ - first), bit_pos);
+        }
+        words_.shrink_to_fit();
+    }
+
+    IntegerColumn(const IntegerColumn& rhs) = default;
+    IntegerColumn(IntegerColumn&& rhs) noexcept = default;
+    ~IntegerColumn() noexcept = default;
+
+    IntegerColumn& operator=(const IntegerColumn& rhs) = default;
+    IntegerColumn& operator=(IntegerColumn&& rhs) noexcept = default;
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t block_size() const {
+        return block_size_;
+    }
+
+    size_t block_count() const {
+        return blocks_.size();
+    }
+
+    /**
+     * @brief get the count of values in a block
+     * @param block the index of the block
+     * @return the count of values
+     */
+    size_t block_rows(size_t block) const {
+        return std::min(block_size_, size_ - block * block_size_);
+    }
+
+    Integer block_min(size_t block) const {
+        return blocks_.at(block).min;
+    }
+
+    Integer block_max(size_t block) const {
+        return blocks_.at(block).max;
+    }
+
+    IntegerEncoding block_encoding(size_t block) const {
+        return blocks_.at(block).encoding;
+    }
+
+    unsigned block_bits(size_t block) const {
+        return blocks_.at(block).bits;
+    }
+
+    /**
+     * @brief get the size of the compressed data in bytes
+     * @return the count of bytes
+     */
+    size_t compressed_bytes() const {
+        return blocks_.size() * sizeof(Block) +
+            words_.size() * sizeof(std::uint64_t);
+    }
+
+    /**
+     * @brief decompress a block
+     * @param block the index of the block
+     * @param out the array of at least block_size() values to receive the
+     * block
+     * @return the count of values written
+     */
+    size_t decode_block(size_t block, Integer* out) const {
+        return for_each_in_block(
+            block, [out](size_t i, Integer value) { out[i] = value; });
+    }
+
+    /**
+     * @brief decompress a block without a buffer
+     * @param block the index of the block
+     * @param f the function called with the offset in the block and the value
+     * @return the count of values visited
+     */
+    template <typename F>
+    size_t for_each_in_block(size_t block, F&& f) const {
+        const Block& b = blocks_.at(block);
+        size_t count = block_rows(block);
+        size_t pos = b.bit_offset;
+        if (b.encoding == IntegerEncoding::Delta) {
+            std::uint64_t value = static_cast<std::uint64_t>(b.reference);
+            f(0, b.reference);
+            for (size_t i = 1; i < count; ++i, pos += b.bits) {
+                value += detail::zigzag_decode(
+                    detail::unpack_bits(words_.data(), pos, b.bits));
+                f(i, static_cast<Integer>(value));
+            }
+        } else {
+            std::uint64_t reference = static_cast<std::uint64_t>(b.reference);
+            for (size_t i = 0; i < count; ++i, pos += b.bits) {
+                f(i, static_cast<Integer>(
+                         reference +
+                         detail::unpack_bits(words_.data(), pos, b.bits)));
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief get a value, O(1) for frame-of-reference blocks and linear in
+     * the block size for delta blocks
+     * @param idx the index of the value
+     * @return the value
+     */
+    Integer at(size_t idx) const {
+        if (idx >= size_) {
+            throw std::out_of_range("column index out of range");
+        }
+        const Block& b = blocks_[idx / block_size_];
+        size_t offset = idx % block_size_;
+        if (b.encoding == IntegerEncoding::FrameOfReference) {
+            return static_cast<Integer>(
+                static_cast<std::uint64_t>(b.reference) +
+                detail::unpack_bits(words_.data(),
+                                    b.bit_offset + offset * b.bits, b.bits));
+        }
+        std::uint64_t value = static_cast<std::uint64_t>(b.reference);
+        for (size_t i = 0; i < offset; ++i) {
+            value += detail::zigzag_decode(detail::unpack_bits(
+                words_.data(), b.bit_offset + i * b.bits, b.bits));
+        }
+        return static_cast<Integer>(value);
+    }
+
+    /**
+     * @brief decompress the whole column
+     * @return the values
+     */
+    std::vector<Integer> decode() const {
+        std::vector<Integer> res(size_);
+        for (size_t b = 0; b < blocks_.size(); ++b) {
+            decode_block(b, res.data() + b * block_size_);
+        }
+        return res;
+    }
+
+    /**
+     * @brief visit the values a block at a time
+     * @param f the function called with the index and the value
+     */
+    template <typename F>
+    void for_each(F&& f) const {
+        for (size_t b = 0; b < blocks_.size(); ++b) {
+            size_t first = b * block_size_;
+            for_each_in_block(b, [first, &f](size_t i, Integer value) {
+                f(first + i, value);
+            });
+        }
+    }
+
+    /**
+     * @brief find the values in [lo, hi], the blocks out of the range are
+     * skipped and the blocks inside the range are taken without decoding
+     * @param lo the lower bound
+     * @param hi the upper bound
+     * @return the indices of the matching values in ascending order
+     */
+    std::vector<size_t> select_range(Integer lo, Integer hi) const {
+        std::vector<size_t> res;
+        for (size_t b = 0; b < blocks_.size(); ++b) {
+            const Block& block = blocks_[b];
+            size_t first = b * block_size_;
+            size_t count = block_rows(b);
+            if (block.max < lo || block.min > hi) {
+                continue;
+            }
+            if (block.min >= lo && block.max <= hi) {
+                for (size_t i = 0; i < count; ++i) {
+                    res.push_back(first + i);
+                }
+                continue;
+            }
+            for_each_in_block(b, [&](size_t i, Integer value) {
+                if (value >= lo && value <= hi) {
+                    res.push_back(first + i);
+                }
+            });
+        }
+        return res;
+    }
+};
+
+/**
+ * @class DateTimeColumn
+ * @brief a column of date times compressed as an IntegerColumn of the seconds
+ * since the epoch
+ */
+class DateTimeColumn {
+private:
+    IntegerColumn seconds_;
+
+    static std::vector<Integer>
+    to_seconds(const std::vector<DateTime>& values) {
+        std::vector<Integer> res;
+        res.reserve(values.size());
+        for (const auto& value : values) {
+            res.push_back(value.seconds_since_epoch());
+        }
+        return res;
+    }
+
+public:
+    explicit DateTimeColumn(
+        const std::vector<DateTime>& values,
+        size_t block_size = IntegerColumn::default_block_size)
+        : seconds_(to_seconds(values), block_size) {}
+
+    DateTimeColumn(const DateTimeColumn& rhs) = default;
+    DateTimeColumn(DateTimeColumn&& rhs) noexcept = default;
+    ~DateTimeColumn() noexcept = default;
+
+    DateTimeColumn& operator=(const DateTimeColumn& rhs) = default;
+    DateTimeColumn& operator=(DateTimeColumn&& rhs) noexcept = default;
+
+    size_t size() const {
+        return seconds_.size();
+    }
+
+    size_t block_size() const {
+        return seconds_.block_size();
+    }
+
+    size_t block_count() const {
+        return seconds_.block_count();
+    }
+
+    size_t compressed_bytes() const {
+        return seconds_.compressed_bytes();
+    }
+
+    /**
+     * @brief get the underlying column of seconds since the epoch
+     * @return the const reference of the column
+     */
+    const IntegerColumn& seconds() const {
+        return seconds_;
+    }
+
+    /**
+     * @brief decompress a block
+     * @param block the index of the block
+     * @param out the array of at least block_size() values to receive the
+     * block
+     * @return the count of values written
+     */
+    size_t decode_block(size_t block, DateTime* out) const {
+        return seconds_.for_each_in_block(
+            block, [out](size_t i, Integer value) {
+                out[i] = DateTime::from_seconds_since_epoch(value);
+            });
+    }
+
+    DateTime at(size_t idx) const {
+        return DateTime::from_seconds_since_epoch(seconds_.at(idx));
+    }
+
+    std::vector<DateTime> decode() const {
+        std::vector<DateTime> res;
+        res.reserve(size());
+        seconds_.for_each([&res](size_t, Integer value) {
+            res.push_back(DateTime::from_seconds_since_epoch(value));
+        });
+        return res;
+    }
+
+    /**
+     * @brief find the date times in [lo, hi] without decoding the blocks
+     * out of or inside the range
+     * @param lo the lower bound
+     * @param hi the upper bound
+     * @return the indices of the matching values in ascending order
+     */
+    std::vector<size_t> select_range(const DateTime& lo,
+                                     const DateTime& hi) const {
+        return seconds_.select_range(lo.seconds_since_epoch(),
+                                     hi.seconds_since_epoch());
+    }
+};
+
+/**
+ * @class BooleanColumn
+ * @brief a column of booleans stored as a bitmap
+ */
+class BooleanColumn {
+public:
+    // the count of values per block, one word of the bitmap
+    static constexpr size_t block_bits = 64;
+
+private:
+    size_t size_;
+    std::vector<std::uint64_t> words_;
+
+public:
+    explicit BooleanColumn(const std::vector<bool>& values)
+        : size_(values.size()), words_((values.size() + 63) / 64, 0) {
+        for (size_t i = 0; i < size_; ++i) {
+            if (values[i]) {
+                words_[i / 64] |= std::uint64_t(1) << (i % 64);
+            }
+        }
+    }
+
+    BooleanColumn(const BooleanColumn& rhs) = default;
+    BooleanColumn(BooleanColumn&& rhs) noexcept = default;
+    ~BooleanColumn() noexcept = default;
+
+    BooleanColumn& operator=(const BooleanColumn& rhs) = default;
+    BooleanColumn& operator=(BooleanColumn&& rhs) noexcept = default;
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t block_size() const {
+        return block_bits;
+    }
+
+    size_t block_count() const {
+        return words_.size();
+    }
+
+    size_t compressed_bytes() const {
+        return words_.size() * sizeof(std::uint64_t);
+    }
+
+    /**
+     * @brief get the raw word of a block, bit i is the value of the row
+     * block * 64 + i
+     * @param block the index of the block
+     * @return the word
+     */
+    std::uint64_t block_word(size_t block) const {
+        return words_.at(block);
+    }
+
+    /**
+     * @brief decompress a block
+     * @param block the index of the block
+     * @param out the array of at least 64 values to receive the block
+     * @return the count of values written
+     */
+    size_t decode_block(size_t block, bool* out) const {
+        std::uint64_t word = words_.at(block);
+        size_t count = std::min<size_t>(64, size_ - block * 64);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = (word >> i) & 1;
+        }
+        return count;
+    }
+
+    bool at(size_t idx) const {
+        if (idx >= size_) {
+            throw std::out_of_range("column index out of range");
+        }
+        return (words_[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    std::vector<bool> decode() const {
+        std::vector<bool> res(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            res[i] = (words_[i / 64] >> (i % 64)) & 1;
+        }
+        return res;
+    }
+
+    /**
+     * @brief count the true values with a popcount per word
+     * @return the count of true values
+     */
+    size_t count() const {
+        size_t res = 0;
+        for (auto word : words_) {
+            res += std::bitset<64>(word).count();
+        }
+        return res;
+    }
+
+    /**
+     * @brief find the rows holding a value by walking the set bits
+     * @param value the value to find
+     * @return the indices of the matching rows in ascending order
+     */
+    std::vector<size_t> select(bool value) const {
+        std::vector<size_t> res;
+        for (size_t w = 0; w < words_.size(); ++w) {
+            std::uint64_t word = value ? words_[w] : ~words_[w];
+            size_t count = std::min<size_t>(64, size_ - w * 64);
+            if (count < 64) {
+                word &= (std::uint64_t(1) << count) - 1;
+            }
+            while (word != 0) {
+                res.push_back(w * 64 + detail::count_trailing_zeros(word));
+                word &= word - 1;
+            }
+        }
+        return res;
+    }
+};
+
+/**
+ * @class RunLengthColumn
+ * @brief a column stored as runs of equal values, intended for sorted keys
+ * @tparam T the type of the values
+ */
+template <typename T>
+class RunLengthColumn {
+public:
+    static constexpr size_t default_block_size = 128;
+
+private:
+    size_t block_size_;
+    std::vector<T> values_;
+    // the index one past the last row of every run
+    std::vector<size_t> ends_;
+
+    size_t run_of(size_t idx) const {
+        return std::upper_bound(ends_.begin(), ends_.end(), idx) -
+            ends_.begin();
+    }
+
+public:
+    explicit RunLengthColumn(const std::vector<T>& values,
+                             size_t block_size = default_block_size)
+        : block_size_(block_size) {
+        if (block_size_ == 0) {
+            throw std::invalid_argument("block size must be positive");
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values_.empty() || !(values_.back() == values[i])) {
+                values_.push_back(values[i]);
+                ends_.push_back(i + 1);
+            } else {
+                ++ends_.back();
+            }
+        }
+    }
+
+    RunLengthColumn(const RunLengthColumn& rhs) = default;
+    RunLengthColumn(RunLengthColumn&& rhs) noexcept = default;
+    ~RunLengthColumn() noexcept = default;
+
+    RunLengthColumn& operator=(const RunLengthColumn& rhs) = default;
+    RunLengthColumn& operator=(RunLengthColumn&& rhs) noexcept = default;
+
+    size_t size() const {
+        return ends_.empty() ? 0 : ends_.back();
+    }
+
+    size_t run_count() const {
+        return values_.size();
+    }
+
+    size_t block_size() const {
+        return block_size_;
+    }
+
+    size_t block_count() const {
+        return (size() + block_size_ - 1) / block_size_;
+    }
+
+    /**
+     * @brief get the value of a row by a binary search over the runs
+     * @param idx the index of the row
+     * @return the const reference of the value
+     */
+    const T& at(size_t idx) const {
+        if (idx >= size()) {
+            throw std::out_of_range("column index out of range");
+        }
+        return values_[run_of(idx)];
+    }
+
+    /**
+     * @brief decompress a block
+     * @param block the index of the block
+     * @param out the array of at least block_size() values to receive the
+     * block
+     * @return the count of values written
+     */
+    size_t decode_block(size_t block, T* out) const {
+        if (block >= block_count()) {
+            throw std::out_of_range("block index out of range");
+        }
+        size_t first = block * block_size_;
+        size_t last = std::min(first + block_size_, size());
+        size_t run = run_of(first);
+        for (size_t i = first; i < last; ++i) {
+            if (i >= ends_[run]) {
+                ++run;
+            }
+            out[i - first] = values_[run];
+        }
+        return last - first;
+    }
+
+    std::vector<T> decode() const {
+        std::vector<T> res;
+        res.reserve(size());
+        for (size_t run = 0; run < values_.size(); ++run) {
+            res.insert(res.end(), ends_[run] - (run ? ends_[run - 1] : 0),
+                       values_[run]);
+        }
+        return res;
+    }
+
+    /**
+     * @brief visit the runs without expanding them
+     * @param f the function called with the value, the index of the first
+     * row and the length of every run
+     */
+    template <typename F>
+    void for_each_run(F&& f) const {
+        for (size_t run = 0; run < values_.size(); ++run) {
+            size_t first = run ? ends_[run - 1] : 0;
+            f(values_[run], first, ends_[run] - first);
+        }
+    }
+
+    /**
+     * @brief find the rows holding a key, the column must be sorted
+     * @param key the key to find
+     * @return the half-open range of the matching rows
+     */
+    std::pair<size_t, size_t> equal_range(const T& key) const {
+        auto it = std::lower_bound(values_.begin(), values_.end(), key);
+        size_t run = it - values_.begin();
+        size_t first = run ? ends_[run - 1] : 0;
+        if (it == values_.end() || !(*it == key)) {
+            return {first, first};
+        }
+        return {first, ends_[run]};
+    }
+};
+
+/**
+ * @brief the codec of the field types which have a dedicated column codec
+ * @tparam Field the type of the field
+ */
+template <typename Field>
+struct column_codec;
+
+template <>
+struct column_codec<IntegerField> {
+    using type = IntegerColumn;
+};
+
+template <>
+struct column_codec<DateTimeField> {
+    using type = DateTimeColumn;
+};
+
+template <>
+struct column_codec<BooleanField> {
+    using type = BooleanColumn;
+};
+
+template <typename Field>
+using column_codec_t = typename column_codec<Field>::type;
+
+/**
+ * @brief compress the Nth field of the items with the codec of its type
+ * @tparam N the index of the field
+ * @param items the items
+ * @return the compressed column
+ */
+template <size_t N, typename Item>
+column_codec_t<field_t<N, Item>>
+compress_column(const std::vector<Item>& items) {
+    std::vector<field_value_t<N, Item>> values;
+    values.reserve(items.size());
+    for (const auto& item : items) {
+        values.push_back(item.template get_field_value<N>());
+    }
+    return column_codec_t<field_t<N, Item>>(values);
+}
+
+/**
+ * @brief compress the Nth field of the items as runs, intended for the key
+ * the items are sorted by
+ * @tparam N the index of the field
+ * @param items the items
+ * @return the run-length encoded column
+ */
+template <size_t N, typename Item>
+RunLengthColumn<field_value_t<N, Item>>
+compress_runs(const std::vector<Item>& items) {
+    std::vector<field_value_t<N, Item>> values;
+    values.reserve(items.size());
+    for (const auto& item : items) {
+        values.push_back(item.template get_field_value<N>());
+    }
+    return RunLengthColumn<field_value_t<N, Item>>(values);
+}
+} // namespace msf
+#endif
@@ -4,6 +4,7 @@
 #include <fmt/base.h>
 #include <fmt/format.h>
 #include <msf/DateTime.hpp>
+#include <msf/memory.hpp>
 #include <msf/types.hpp>
 #include <sstream>
 #include <stdexcept>
@@ -58,6 +59,25 @@ public:
     static constexpr c_string type() {
         return "Basic";
     }
+
+    /**
+     * @brief get the size of a field, the value with the vptr and the padding
+     * @return the count of bytes
+     */
+    static constexpr size_t inline_size() {
+        return sizeof(BasicField);
+    }
+
+    /**
+     * @brief get the memory of the field
+     * @return the inline bytes and the heap storage of the value
+     */
+    MemoryUsage memory_usage() const {
+        MemoryUsage res = detail::heap_usage(value_);
+        res.inline_bytes = inline_size();
+        res.overhead_bytes = inline_size() - sizeof(T);
+        return res;
+    }
 };
 
 /**
@@ -202,6 +222,7 @@ class DateField : public BasicField<Date> {
 public:
     using BasicField<Date>::BasicField;
 
+    DateField() = default;
     DateField(const DateField& rhs) = default;
     DateField(DateField&& rhs) noexcept = default;
 
@@ -294,8 +315,11 @@ public:
         std::istringstream iss(str);
         char delimeter;
         iss >> value().year >> delimeter >> value().month >> delimeter >>
-            value().day >> delimeter >> value().hour >> delimeter >>
-            value().minute >> delimeter >> value().second;
+            value().day;
+        // the separator of the date and the time may be a space
+        iss.get(delimeter);
+        iss >> value().hour >> delimeter >> value().minute >> delimeter >>
+            value().second;
         if (iss.fail()) {
             throw std::invalid_argument(
                 fmt::format("Unable to convert {} to DateTime", str));
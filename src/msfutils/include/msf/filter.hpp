@@ -0,0 +1,575 @@
+#ifndef PMS_FILTER_HPP
+#define PMS_FILTER_HPP
+
+#include <array>
+#include <cctype>
+#include <fmt/format.h>
+#include <functional>
+#include <memory>
+#include <msf/BasicItem.hpp>
+#include <msf/DateTime.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace msf {
+namespace detail {
+
+// the parentheses and the negations open at once in a filter, bounded so a
+// malformed expression cannot exhaust the stack
+constexpr size_t max_filter_depth = 256;
+
+/**
+ * @brief a token of a filter expression
+ */
+struct FilterToken {
+    enum class Kind { Word, Quoted, Compare, LParen, RParen, End };
+
+    Kind kind;
+    string text;
+    // the position in the expression
+    size_t pos;
+};
+
+/**
+ * @brief split a filter expression into tokens, a word is a run of the
+ * characters other than spaces, parentheses, quotes and comparison operators
+ * @param expression the expression
+ * @return the tokens ended by an End token
+ */
+inline std::vector<FilterToken> tokenize_filter(const string& expression) {
+    using Kind = FilterToken::Kind;
+    auto is_compare = [](char c) {
+        return c == '=' || c == '!' || c == '<' || c == '>';
+    };
+    std::vector<FilterToken> res;
+    size_t pos = 0;
+    while (pos < expression.size()) {
+        char c = expression[pos];
+        size_t start = pos;
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++pos;
+        } else if (c == '(' || c == ')') {
+            res.push_back({c == '(' ? Kind::LParen : Kind::RParen,
+                           string(1, c), start});
+            ++pos;
+        } else if (c == '"' || c == '\'') {
+            size_t end = expression.find(c, pos + 1);
+            if (end == string::npos) {
+                throw std::invalid_argument(fmt::format(
+                    "unterminated string at {} in filter", start));
+            }
+            res.push_back({Kind::Quoted,
+                           expression.substr(pos + 1, end - pos - 1), start});
+            pos = end + 1;
+        } else if (is_compare(c)) {
+            while (pos < expression.size() && is_compare(expression[pos])) {
+                ++pos;
+            }
+            res.push_back(
+                {Kind::Compare, expression.substr(start, pos - start), start});
+        } else {
+            while (pos < expression.size() &&
+                   !std::isspace(static_cast<unsigned char>(expression[pos])) &&
+                   string("()\"'").find(expression[pos]) == string::npos &&
+                   !is_compare(expression[pos])) {
+                ++pos;
+            }
+            res.push_back(
+                {Kind::Word, expression.substr(start, pos - start), start});
+        }
+    }
+    res.push_back({Kind::End, "end of filter", expression.size()});
+    return res;
+}
+
+inline bool is_keyword(const FilterToken& token, c_string keyword) {
+    if (token.kind != FilterToken::Kind::Word) {
+        return false;
+    }
+    size_t i = 0;
+    for (; keyword[i] != '\0'; ++i) {
+        if (i == token.text.size() ||
+            std::tolower(static_cast<unsigned char>(token.text[i])) !=
+                keyword[i]) {
+            return false;
+        }
+    }
+    return i == token.text.size();
+}
+
+/**
+ * @brief check that the whole literal was read, `3abc` or `3.5` are not read
+ * as an integer 3
+ */
+inline void check_literal_end(std::istringstream& iss, const string& text) {
+    if (iss.fail() || !(iss >> std::ws).eof()) {
+        throw std::invalid_argument(
+            fmt::format("unexpected characters in literal {}", text));
+    }
+}
+
+/**
+ * @brief parse a literal of a filter holding a number
+ */
+template <typename Field>
+std::decay_t<decltype(std::declval<const Field&>().value())>
+parse_filter_literal(const string& text, Field*) {
+    std::decay_t<decltype(std::declval<const Field&>().value())> value;
+    std::istringstream iss(text);
+    iss >> value;
+    check_literal_end(iss, text);
+    return value;
+}
+
+inline bool parse_filter_literal(const string& text, BooleanField*) {
+    return BooleanField(text).value();
+}
+
+inline string parse_filter_literal(const string& text, TextField*) {
+    return text;
+}
+
+/**
+ * @brief the dates and the times are read in the formats of their string
+ * constructors and rebuilt by the validating constructors
+ */
+inline Date parse_filter_literal(const string& text, DateField*) {
+    std::istringstream iss(text);
+    Integer year, month, day;
+    char delimeter;
+    iss >> year >> delimeter >> month >> delimeter >> day;
+    check_literal_end(iss, text);
+    return Date(year, month, day);
+}
+
+inline Time parse_filter_literal(const string& text, TimeField*) {
+    std::istringstream iss(text);
+    Integer hour, minute, second;
+    char delimeter;
+    iss >> hour >> delimeter >> minute >> delimeter >> second;
+    check_literal_end(iss, text);
+    return Time(hour, minute, second);
+}
+
+/**
+ * @brief a date alone compares as the midnight of the date
+ */
+inline DateTime parse_filter_literal(const string& text, DateTimeField*) {
+    if (text.find_first_of(" T") == string::npos) {
+        Date date =
+            parse_filter_literal(text, static_cast<DateField*>(nullptr));
+        return DateTime(date.year, date.month, date.day, 0, 0, 0);
+    }
+    std::istringstream iss(text);
+    Integer year, month, day, hour, minute, second;
+    char delimeter;
+    iss >> year >> delimeter >> month >> delimeter >> day;
+    // the separator of the date and the time may be a space
+    iss.get(delimeter);
+    iss >> hour >> delimeter >> minute >> delimeter >> second;
+    check_literal_end(iss, text);
+    return DateTime(year, month, day, hour, minute, second);
+}
+
+template <typename Item>
+auto filter_field_names(int) -> decltype(Item::get_field_names()) {
+    return Item::get_field_names();
+}
+
+/**
+ * @brief the items without get_field_names() cannot be filtered by name
+ */
+template <typename Item>
+std::array<c_string, Item::get_field_count()> filter_field_names(long) {
+    static_assert(Item::get_field_count() == 0,
+                  "the filtered item must provide get_field_names()");
+    return {};
+}
+} // namespace detail
+
+/**
+ * @class Filter
+ * @brief a filter over items compiled from an expression such as
+ * `in_reading = true and (admision_time >= 2024-09-01 or not id < 10)`
+ *
+ * A comparison is a field name, one of `= == != < <= > >=` and a literal,
+ * quoted if it holds spaces. The literal is parsed once in the format of the
+ * string constructor of the field, so the rows are compared on their typed
+ * values, and a literal with characters left over is rejected. A Boolean
+ * field alone tests whether it is true. The keywords `and`, `or` and `not`
+ * are matched in any case, the constants `true` and `false` only in lower
+ * case like the Boolean literals. At most 256 parentheses and negations may
+ * be open at once. The expression compiles to a tree of typed nodes, the
+ * operands known at compile time are folded and `and` and `or`
+ * short-circuit.
+ * @tparam Item the type of the items, must provide get_field_names()
+ */
+template <typename Item>
+class Filter {
+private:
+    enum class Compare { Equal, NotEqual, Less, LessEqual, Greater,
+                         GreaterEqual };
+
+    struct Node {
+        virtual ~Node() = default;
+        virtual bool eval(const Item& item) const = 0;
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Constant : Node {
+        bool value;
+
+        explicit Constant(bool value) : value(value) {}
+
+        bool eval(const Item&) const override {
+            return value;
+        }
+    };
+
+    struct And : Node {
+        NodePtr lhs;
+        NodePtr rhs;
+
+        And(NodePtr lhs, NodePtr rhs)
+            : lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+        bool eval(const Item& item) const override {
+            return lhs->eval(item) && rhs->eval(item);
+        }
+    };
+
+    struct Or : Node {
+        NodePtr lhs;
+        NodePtr rhs;
+
+        Or(NodePtr lhs, NodePtr rhs)
+            : lhs(std::move(lhs)), rhs(std::move(rhs)) {}
+
+        bool eval(const Item& item) const override {
+            return lhs->eval(item) || rhs->eval(item);
+        }
+    };
+
+    struct Not : Node {
+        NodePtr operand;
+
+        explicit Not(NodePtr operand) : operand(std::move(operand)) {}
+
+        bool eval(const Item& item) const override {
+            return !operand->eval(item);
+        }
+    };
+
+    template <size_t N, typename Op>
+    struct Comparison : Node {
+        field_value_t<N, Item> literal;
+
+        explicit Comparison(field_value_t<N, Item> literal)
+            : literal(std::move(literal)) {}
+
+        bool eval(const Item& item) const override {
+            return Op()(item.template get_field_value<N>(), literal);
+        }
+    };
+
+    using comparison_maker = NodePtr (*)(Compare, const string&);
+
+    template <size_t N>
+    static NodePtr make_comparison(Compare op, const string& text) {
+        using value_type = field_value_t<N, Item>;
+        value_type literal = detail::parse_filter_literal(
+            text, static_cast<field_t<N, Item>*>(nullptr));
+        switch (op) {
+        case Compare::Equal:
+            return std::make_shared<
+                Comparison<N, std::equal_to<value_type>>>(literal);
+        case Compare::NotEqual:
+            return std::make_shared<
+                Comparison<N, std::not_equal_to<value_type>>>(literal);
+        case Compare::Less:
+            return std::make_shared<Comparison<N, std::less<value_type>>>(
+                literal);
+        case Compare::LessEqual:
+            return std::make_shared<
+                Comparison<N, std::less_equal<value_type>>>(literal);
+        case Compare::Greater:
+            return std::make_shared<Comparison<N, std::greater<value_type>>>(
+                literal);
+        default:
+            return std::make_shared<
+                Comparison<N, std::greater_equal<value_type>>>(literal);
+        }
+    }
+
+    template <size_t... Is>
+    static comparison_maker maker_of(size_t field, std::index_sequence<Is...>) {
+        static const comparison_maker makers[] = {
+            &Filter::make_comparison<Is>...};
+        return makers[field];
+    }
+
+    static bool constant_of(const NodePtr& node, bool& value) {
+        auto constant = dynamic_cast<const Constant*>(node.get());
+        if (constant != nullptr) {
+            value = constant->value;
+        }
+        return constant != nullptr;
+    }
+
+    static NodePtr make_and(NodePtr lhs, NodePtr rhs) {
+        bool value;
+        if (constant_of(lhs, value)) {
+            return value ? rhs : lhs;
+        }
+        if (constant_of(rhs, value)) {
+            return value ? lhs : rhs;
+        }
+        return std::make_shared<And>(std::move(lhs), std::move(rhs));
+    }
+
+    static NodePtr make_or(NodePtr lhs, NodePtr rhs) {
+        bool value;
+        if (constant_of(lhs, value)) {
+            return value ? lhs : rhs;
+        }
+        if (constant_of(rhs, value)) {
+            return value ? rhs : lhs;
+        }
+        return std::make_shared<Or>(std::move(lhs), std::move(rhs));
+    }
+
+    static NodePtr make_not(NodePtr operand) {
+        bool value;
+        if (constant_of(operand, value)) {
+            return std::make_shared<Constant>(!value);
+        }
+        auto inner = dynamic_cast<const Not*>(operand.get());
+        if (inner != nullptr) {
+            return inner->operand;
+        }
+        return std::make_shared<Not>(std::move(operand));
+    }
+
+    /**
+     * @class Parser
+     * @brief the recursive descent parser of the expressions
+     */
+    class Parser {
+    private:
+        std::vector<detail::FilterToken> tokens_;
+        size_t pos_;
+        size_t depth_;
+
+        using Kind = detail::FilterToken::Kind;
+
+        const detail::FilterToken& peek() const {
+            return tokens_[pos_];
+        }
+
+        [[noreturn]] void fail(const detail::FilterToken& token,
+                               const string& expected) const {
+            throw std::invalid_argument(
+                fmt::format("expected {} but found {} at {} in filter",
+                            expected, token.text, token.pos));
+        }
+
+        void enter(const detail::FilterToken& token) {
+            if (++depth_ > detail::max_filter_depth) {
+                throw std::invalid_argument(
+                    fmt::format("filter nested too deeply at {}, at most {} "
+                                "parentheses and negations are allowed",
+                                token.pos, detail::max_filter_depth));
+            }
+        }
+
+        NodePtr parse_or() {
+            NodePtr res = parse_and();
+            while (detail::is_keyword(peek(), "or")) {
+                ++pos_;
+                res = make_or(res, parse_and());
+            }
+            return res;
+        }
+
+        NodePtr parse_and() {
+            NodePtr res = parse_unary();
+            while (detail::is_keyword(peek(), "and")) {
+                ++pos_;
+                res = make_and(res, parse_unary());
+            }
+            return res;
+        }
+
+        NodePtr parse_unary() {
+            if (detail::is_keyword(peek(), "not")) {
+                enter(tokens_[pos_++]);
+                NodePtr res = make_not(parse_unary());
+                --depth_;
+                return res;
+            }
+            return parse_primary();
+        }
+
+        NodePtr parse_primary() {
+            const detail::FilterToken& token = tokens_[pos_++];
+            if (token.kind == Kind::LParen) {
+                enter(token);
+                NodePtr res = parse_or();
+                if (peek().kind != Kind::RParen) {
+                    fail(peek(), "')'");
+                }
+                ++pos_;
+                --depth_;
+                return res;
+            }
+            // the constants are spelled as the Boolean literals
+            if (token.kind == Kind::Word &&
+                (token.text == "true" || token.text == "false")) {
+                return std::make_shared<Constant>(token.text == "true");
+            }
+            if (token.kind != Kind::Word) {
+                fail(token, "a field name");
+            }
+            return parse_comparison(token);
+        }
+
+        NodePtr parse_comparison(const detail::FilterToken& name) {
+            auto names = detail::filter_field_names<Item>(0);
+            auto types = Item::get_field_types();
+            size_t field = 0;
+            while (field < names.size() && name.text != names[field]) {
+                ++field;
+            }
+            if (field == names.size()) {
+                throw std::invalid_argument(fmt::format(
+                    "unknown field {} at {} in filter", name.text, name.pos));
+            }
+
+            Compare op = Compare::Equal;
+            string literal = "true";
+            if (peek().kind == Kind::Compare) {
+                op = compare_of(tokens_[pos_++]);
+                const detail::FilterToken& value = tokens_[pos_++];
+                if (value.kind != Kind::Word && value.kind != Kind::Quoted) {
+                    fail(value, fmt::format("a {} literal", types[field]));
+                }
+                literal = value.text;
+            } else if (string(types[field]) != BooleanField::type()) {
+                fail(peek(), "a comparison operator");
+            }
+
+            try {
+                return maker_of(
+                    field,
+                    std::make_index_sequence<Item::get_field_count()>())(
+                    op, literal);
+            } catch (const std::invalid_argument&) {
+                throw std::invalid_argument(
+                    fmt::format("invalid {} literal {} for field {} in filter",
+                                types[field], literal, name.text));
+            }
+        }
+
+        Compare compare_of(const detail::FilterToken& token) const {
+            const string& text = token.text;
+            if (text == "=" || text == "==") {
+                return Compare::Equal;
+            } else if (text == "!=") {
+                return Compare::NotEqual;
+            } else if (text == "<") {
+                return Compare::Less;
+            } else if (text == "<=") {
+                return Compare::LessEqual;
+            } else if (text == ">") {
+                return Compare::Greater;
+            } else if (text == ">=") {
+                return Compare::GreaterEqual;
+            }
+            fail(token, "a comparison operator");
+        }
+
+    public:
+        explicit Parser(const string& expression)
+            : tokens_(detail::tokenize_filter(expression)), pos_(0),
+              depth_(0) {}
+
+        NodePtr parse() {
+            NodePtr res = parse_or();
+            if (peek().kind != Kind::End) {
+                fail(peek(), "'and', 'or' or the end of filter");
+            }
+            return res;
+        }
+    };
+
+    NodePtr root_;
+
+public:
+    /**
+     * @brief compile a filter expression
+     * @param expression the expression
+     */
+    explicit Filter(const string& expression)
+        : root_(Parser(expression).parse()) {}
+
+    Filter(const Filter& rhs) = default;
+    Filter(Filter&& rhs) noexcept = default;
+    ~Filter() noexcept = default;
+
+    Filter& operator=(const Filter& rhs) = default;
+    Filter& operator=(Filter&& rhs) noexcept = default;
+
+    /**
+     * @brief test an item
+     * @param item the item
+     * @return true if the item passes the filter
+     */
+    bool operator()(const Item& item) const {
+        return root_->eval(item);
+    }
+
+    /**
+     * @brief check whether the filter folded to a constant
+     * @param value the variable to receive the constant
+     * @return true if the result does not depend on the items
+     */
+    bool is_constant(bool& value) const {
+        return constant_of(root_, value);
+    }
+};
+
+/**
+ * @brief compile a filter expression
+ * @param expression the expression
+ * @return the filter
+ */
+template <typename Item>
+Filter<Item> compile_filter(const string& expression) {
+    return Filter<Item>(expression);
+}
+
+/**
+ * @brief find the rows of a collection passing a filter
+ * @param items the items
+ * @param filter the filter
+ * @return the indices of the rows in ascending order
+ */
+template <typename Item>
+std::vector<size_t> filter_rows(const std::vector<Item>& items,
+                                const Filter<Item>& filter) {
+    std::vector<size_t> res;
+    for (size_t row = 0; row < items.size(); ++row) {
+        if (filter(items[row])) {
+            res.push_back(row);
+        }
+    }
+    return res;
+}
+} // namespace msf
+#endif
@@ -0,0 +1,66 @@
+#ifndef PMS_HASH_HPP
+#define PMS_HASH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <msf/DateTime.hpp>
+#include <msf/types.hpp>
+
+namespace msf {
+
+/**
+ * @class value_hash
+ * @brief the hash of the field values, every bit of the result depends on
+ * every bit of the value so that the hash tables may use the low bits as the
+ * slot and the high bits as the partition
+ */
+struct value_hash {
+    /**
+     * @brief the finalizer of splitmix64
+     * @param x the value to mix
+     * @return the mixed value
+     */
+    static std::uint64_t mix(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    std::uint64_t operator()(Integer value) const {
+        return mix(static_cast<std::uint64_t>(value));
+    }
+
+    std::uint64_t operator()(bool value) const {
+        return mix(value ? 1 : 0);
+    }
+
+    std::uint64_t operator()(double value) const {
+        // +0.0 and -0.0 are equal and must hash equally
+        if (value == 0) {
+            value = 0;
+        }
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return mix(bits);
+    }
+
+    std::uint64_t operator()(const string& value) const {
+        return mix(std::hash<string>()(value));
+    }
+
+    std::uint64_t operator()(const Date& value) const {
+        return mix(static_cast<std::uint64_t>(value.days_since_epoch()));
+    }
+
+    std::uint64_t operator()(const Time& value) const {
+        return mix(static_cast<std::uint64_t>(value.seconds_of_day()));
+    }
+
+    std::uint64_t operator()(const DateTime& value) const {
+        return mix(static_cast<std::uint64_t>(value.seconds_since_epoch()));
+    }
+};
+} // namespace msf
+#endif
@@ -0,0 +1,309 @@
+#ifndef PMS_JOIN_HPP
+#define PMS_JOIN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <msf/BasicItem.hpp>
+#include <msf/hash.hpp>
+#include <msf/types.hpp>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @class JoinedRow
+ * @brief a pair of matching rows of a join, referring to the items in their
+ * containers
+ * @tparam L the type of the left items
+ * @tparam R the type of the right items
+ */
+template <typename L, typename R>
+struct JoinedRow {
+    const L* left;
+    const R* right;
+};
+
+namespace detail {
+
+// the end of a chain of rows
+constexpr size_t join_npos = static_cast<size_t>(-1);
+
+/**
+ * @class FlatJoinTable
+ * @brief an open-addressing hash table with linear probing, a slot holds a
+ * distinct key and the head of the chain of the rows sharing it
+ * @tparam Key the type of the key
+ */
+template <typename Key>
+class FlatJoinTable {
+private:
+    struct Slot {
+        std::uint64_t hash;
+        // nullptr marks an empty slot
+        const Key* key;
+        size_t head;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<size_t> next_;
+    size_t mask_;
+
+public:
+    /**
+     * @brief create a table for a count of rows, kept at most half full
+     * @param rows the count of rows to insert
+     */
+    explicit FlatJoinTable(size_t rows) : next_(rows, join_npos) {
+        size_t capacity = 16;
+        while (capacity < rows * 2) {
+            capacity *= 2;
+        }
+        slots_.assign(capacity, Slot {0, nullptr, join_npos});
+        mask_ = capacity - 1;
+    }
+
+    /**
+     * @brief insert a row, the rows of a key are visited in the reverse order
+     * of their insertion
+     * @param id the id of the row, less than the count given on creation
+     * @param key the key of the row, must outlive the table
+     * @param hash the hash of the key
+     */
+    void insert(size_t id, const Key& key, std::uint64_t hash) {
+        for (size_t pos = hash & mask_;; pos = (pos + 1) & mask_) {
+            Slot& slot = slots_[pos];
+            if (slot.key == nullptr) {
+                slot = Slot {hash, &key, id};
+                return;
+            }
+            if (slot.hash == hash && *slot.key == key) {
+                next_[id] = slot.head;
+                slot.head = id;
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief visit the rows of a key
+     * @param key the key
+     * @param hash the hash of the key
+     * @param f the function called with the id of every row
+     */
+    template <typename F>
+    void find(const Key& key, std::uint64_t hash, F&& f) const {
+        for (size_t pos = hash & mask_;; pos = (pos + 1) & mask_) {
+            const Slot& slot = slots_[pos];
+            if (slot.key == nullptr) {
+                return;
+            }
+            if (slot.hash == hash && *slot.key == key) {
+                for (size_t id = slot.head; id != join_npos; id = next_[id]) {
+                    f(id);
+                }
+                return;
+            }
+        }
+    }
+};
+
+/**
+ * @brief join two lists of rows, building the table on the first one
+ * @tparam BN the index of the key field of the build side
+ * @tparam PN the index of the key field of the probe side
+ * @param build the items of the build side
+ * @param build_ids the rows of the build side, nullptr for all of them
+ * @param build_count the count of the rows of the build side
+ * @param probe the items of the probe side
+ * @param probe_ids the rows of the probe side, nullptr for all of them
+ * @param probe_count the count of the rows of the probe side
+ * @param emit the function called with every matching build and probe item
+ */
+template <size_t BN, size_t PN, typename B, typename P, typename Emit>
+void join_rows(const std::vector<B>& build, const size_t* build_ids,
+               size_t build_count, const std::vector<P>& probe,
+               const size_t* probe_ids, size_t probe_count, Emit&& emit) {
+    using Key = field_value_t<BN, B>;
+    value_hash hash;
+    FlatJoinTable<Key> table(build_count);
+    // inserting backwards visits the matches in the order of the build side
+    for (size_t i = build_count; i-- > 0;) {
+        const Key& key =
+            build[build_ids ? build_ids[i] : i].template get_field_value<BN>();
+        table.insert(i, key, hash(key));
+    }
+    for (size_t j = 0; j < probe_count; ++j) {
+        const P& row = probe[probe_ids ? probe_ids[j] : j];
+        const Key& key = row.template get_field_value<PN>();
+        table.find(key, hash(key), [&](size_t i) {
+            emit(build[build_ids ? build_ids[i] : i], row);
+        });
+    }
+}
+
+/**
+ * @brief join two lists of rows, building the table on the smaller one
+ */
+template <size_t LN, size_t RN, typename L, typename R, typename F>
+void join_smaller(const std::vector<L>& left, const size_t* left_ids,
+                  size_t left_count, const std::vector<R>& right,
+                  const size_t* right_ids, size_t right_count, F&& f) {
+    if (left_count <= right_count) {
+        join_rows<LN, RN>(left, left_ids, left_count, right, right_ids,
+                          right_count,
+                          [&f](const L& l, const R& r) { f(l, r); });
+    } else {
+        join_rows<RN, LN>(right, right_ids, right_count, left, left_ids,
+                          left_count,
+                          [&f](const R& r, const L& l) { f(l, r); });
+    }
+}
+} // namespace detail
+
+/**
+ * @brief join two collections on equal fields and visit the matching pairs,
+ * the hash table is built on the smaller collection and the other one is
+ * scanned in order
+ * @tparam LN the index of the key field of the left items
+ * @tparam RN the index of the key field of the right items
+ * @param left the left items
+ * @param right the right items
+ * @param f the function called with every matching left and right item
+ */
+template <size_t LN, size_t RN, typename L, typename R, typename F>
+void hash_join_each(const std::vector<L>& left, const std::vector<R>& right,
+                    F&& f) {
+    static_assert(
+        std::is_same<field_value_t<LN, L>, field_value_t<RN, R>>::value,
+        "the joined fields must have the same value type");
+    detail::join_smaller<LN, RN>(left, nullptr, left.size(), right, nullptr,
+                                 right.size(), f);
+}
+
+/**
+ * @brief join two collections on equal fields
+ * @tparam LN the index of the key field of the left items
+ * @tparam RN the index of the key field of the right items
+ * @param left the left items
+ * @param right the right items
+ * @return the matching pairs, referring to the items in the collections
+ */
+template <size_t LN, size_t RN, typename L, typename R>
+std::vector<JoinedRow<L, R>> hash_join(const std::vector<L>& left,
+                                       const std::vector<R>& right) {
+    std::vector<JoinedRow<L, R>> res;
+    hash_join_each<LN, RN>(left, right, [&res](const L& l, const R& r) {
+        res.push_back(JoinedRow<L, R> {&l, &r});
+    });
+    return res;
+}
+
+/**
+ * @brief join two collections on equal fields with several threads, both
+ * sides are partitioned by the high bits of the hash and the partitions are
+ * joined independently
+ * @tparam LN the index of the key field of the left items
+ * @tparam RN the index of the key field of the right items
+ * @param left the left items
+ * @param right the right items
+ * @param threads the count of threads, 0 for the hardware concurrency
+ * @return the matching pairs grouped by partition, referring to the items in
+ * the collections
+ */
+template <size_t LN, size_t RN, typename L, typename R>
+std::vector<JoinedRow<L, R>>
+parallel_hash_join(const std::vector<L>& left, const std::vector<R>& right,
+                   size_t threads = 0) {
+    static_assert(
+        std::is_same<field_value_t<LN, L>, field_value_t<RN, R>>::value,
+        "the joined fields must have the same value type");
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // a few partitions per thread balance the skewed ones
+    unsigned bits = 0;
+    while ((size_t(1) << bits) < threads * 4) {
+        ++bits;
+    }
+    size_t partitions = size_t(1) << bits;
+
+    value_hash hash;
+    auto partition_of = [bits, &hash](const field_value_t<LN, L>& key) {
+        return bits == 0 ? 0 : static_cast<size_t>(hash(key) >> (64 - bits));
+    };
+
+    std::vector<std::vector<size_t>> left_parts(partitions);
+    std::vector<std::vector<size_t>> right_parts(partitions);
+    for (size_t i = 0; i < left.size(); ++i) {
+        left_parts[partition_of(left[i].template get_field_value<LN>())]
+            .push_back(i);
+    }
+    for (size_t i = 0; i < right.size(); ++i) {
+        right_parts[partition_of(right[i].template get_field_value<RN>())]
+            .push_back(i);
+    }
+
+    std::vector<std::vector<JoinedRow<L, R>>> results(partitions);
+    std::atomic<size_t> next_partition(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto fail = [&]() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error == nullptr) {
+            error = std::current_exception();
+        }
+        next_partition = partitions;
+    };
+    auto worker = [&]() {
+        try {
+            for (size_t p = next_partition++; p < partitions;
+                 p = next_partition++) {
+                auto& out = results[p];
+                detail::join_smaller<LN, RN>(
+                    left, left_parts[p].data(), left_parts[p].size(), right,
+                    right_parts[p].data(), right_parts[p].size(),
+                    [&out](const L& l, const R& r) {
+                        out.push_back(JoinedRow<L, R> {&l, &r});
+                    });
+            }
+        } catch (...) {
+            fail();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        for (size_t t = 1; t < threads; ++t) {
+            pool.emplace_back(worker);
+        }
+    } catch (...) {
+        // the threads started are still joined
+        fail();
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+
+    size_t total = 0;
+    for (const auto& part : results) {
+        total += part.size();
+    }
+    std::vector<JoinedRow<L, R>> res;
+    res.reserve(total);
+    for (const auto& part : results) {
+        res.insert(res.end(), part.begin(), part.end());
+    }
+    return res;
+}
+} // namespace msf
+#endif
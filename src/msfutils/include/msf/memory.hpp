@@ -0,0 +1,150 @@
+#ifndef PMS_MEMORY_HPP
+#define PMS_MEMORY_HPP
+
+#include <array>
+#include <msf/types.hpp>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @class MemoryUsage
+ * @brief the breakdown of the memory held by an object
+ */
+struct MemoryUsage {
+    // the bytes of the object itself, sizeof
+    size_t inline_bytes;
+    // the bytes of the fields and the items not holding values: vptrs and
+    // padding
+    size_t overhead_bytes;
+    // the bytes allocated on the heap by the object
+    size_t heap_bytes;
+    // the heap bytes not holding values: unused capacity and bookkeeping
+    size_t wasted_bytes;
+
+    /**
+     * @brief get the total count of bytes held
+     * @return the inline bytes and the heap bytes
+     */
+    size_t total_bytes() const {
+        return inline_bytes + heap_bytes;
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage& rhs) {
+        inline_bytes += rhs.inline_bytes;
+        overhead_bytes += rhs.overhead_bytes;
+        heap_bytes += rhs.heap_bytes;
+        wasted_bytes += rhs.wasted_bytes;
+        return *this;
+    }
+
+    friend MemoryUsage operator+(MemoryUsage lhs, const MemoryUsage& rhs) {
+        return lhs += rhs;
+    }
+
+    friend bool operator==(const MemoryUsage& lhs, const MemoryUsage& rhs) {
+        return lhs.inline_bytes == rhs.inline_bytes &&
+            lhs.overhead_bytes == rhs.overhead_bytes &&
+            lhs.heap_bytes == rhs.heap_bytes &&
+            lhs.wasted_bytes == rhs.wasted_bytes;
+    }
+
+    friend bool operator!=(const MemoryUsage& lhs, const MemoryUsage& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+namespace detail {
+
+/**
+ * @brief get the heap memory of a value, nothing for the values without heap
+ * storage
+ */
+template <typename T>
+MemoryUsage heap_usage(const T&) {
+    return MemoryUsage {0, 0, 0, 0};
+}
+
+/**
+ * @brief get the heap memory of a string, the short strings are stored
+ * inline and allocate nothing
+ */
+inline MemoryUsage heap_usage(const string& value) {
+    const char* data = value.data();
+    const char* self = reinterpret_cast<const char*>(&value);
+    if (data >= self && data < self + sizeof(value)) {
+        return MemoryUsage {0, 0, 0, 0};
+    }
+    // the terminating null is allocated as well
+    return MemoryUsage {0, 0, value.capacity() + 1,
+                        value.capacity() - value.size()};
+}
+
+/**
+ * @brief get the memory of an item having a memory_usage() of its own
+ */
+template <typename T>
+auto item_memory_usage(const T& item, int) -> decltype(item.memory_usage()) {
+    return item.memory_usage();
+}
+
+/**
+ * @brief get the memory of an item without memory_usage(), its size and the
+ * heap storage of its value
+ */
+template <typename T>
+MemoryUsage item_memory_usage(const T& item, long) {
+    MemoryUsage res = heap_usage(item);
+    res.inline_bytes = sizeof(T);
+    return res;
+}
+
+/**
+ * @brief get the memory of an item, from its memory_usage() if it has one
+ * @param item the item
+ * @return the memory usage
+ */
+template <typename T>
+MemoryUsage item_memory_usage(const T& item) {
+    return item_memory_usage(item, 0);
+}
+} // namespace detail
+
+/**
+ * @brief get the memory of a collection of items, the slots past the size are
+ * wasted capacity
+ * @param items the items
+ * @return the memory usage, the inline bytes are those of the vector
+ */
+template <typename Item>
+MemoryUsage memory_usage(const std::vector<Item>& items) {
+    MemoryUsage res {sizeof(items), 0, items.capacity() * sizeof(Item),
+                     (items.capacity() - items.size()) * sizeof(Item)};
+    for (const auto& item : items) {
+        MemoryUsage usage = detail::item_memory_usage(item);
+        res.overhead_bytes += usage.overhead_bytes;
+        res.heap_bytes += usage.heap_bytes;
+        res.wasted_bytes += usage.wasted_bytes;
+    }
+    return res;
+}
+
+/**
+ * @brief get the memory of a collection of items by field
+ * @param items the items
+ * @return the sums of the memory usage of every field of the items
+ */
+template <typename Item>
+std::array<MemoryUsage, Item::get_field_count()>
+field_memory_usage(const std::vector<Item>& items) {
+    std::array<MemoryUsage, Item::get_field_count()> res {};
+    for (const auto& item : items) {
+        auto fields = item.field_memory_usage();
+        for (size_t i = 0; i < res.size(); ++i) {
+            res[i] += fields[i];
+        }
+    }
+    return res;
+}
+} // namespace msf
+#endif
@@ -0,0 +1,460 @@
+#ifndef PMS_SORT_HPP
+#define PMS_SORT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <msf/BasicItem.hpp>
+#include <msf/DateTime.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace msf {
+
+/**
+ * @brief the order of a sort
+ */
+enum class SortOrder { Ascending, Descending };
+
+/**
+ * @brief the normalized binary key of a field type, the keys of two values
+ * compare with memcmp as the values compare with operator<
+ * @tparam Field the type of the field
+ */
+template <typename Field>
+struct sort_key {
+    // the types without a fixed-width key are sorted by comparison
+    static constexpr bool radix = false;
+    static constexpr size_t width = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief write an unsigned integer in big-endian order
+ * @param value the value
+ * @param bytes the count of bytes to write
+ * @param out the output
+ */
+inline void store_big_endian(std::uint64_t value, size_t bytes,
+                             unsigned char* out) {
+    for (size_t i = bytes; i-- > 0;) {
+        out[i] = static_cast<unsigned char>(value);
+        value >>= 8;
+    }
+}
+
+/**
+ * @brief write a signed integer so that the bytes order as the values
+ * @param value the value
+ * @param out the 8-byte output
+ */
+inline void store_ordered(Integer value, unsigned char* out) {
+    store_big_endian(static_cast<std::uint64_t>(value) ^ (1ULL << 63), 8, out);
+}
+} // namespace detail
+
+template <>
+struct sort_key<IntegerField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width = 8;
+
+    static void encode(Integer value, unsigned char* out) {
+        detail::store_ordered(value, out);
+    }
+};
+
+template <>
+struct sort_key<BooleanField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width = 1;
+
+    static void encode(bool value, unsigned char* out) {
+        out[0] = value ? 1 : 0;
+    }
+};
+
+template <>
+struct sort_key<FloatField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width = 8;
+
+    static void encode(double value, unsigned char* out) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        // flip every bit of the negatives and the sign bit of the positives
+        bits = (bits >> 63) ? ~bits : bits | (1ULL << 63);
+        detail::store_big_endian(bits, 8, out);
+    }
+};
+
+template <>
+struct sort_key<DateField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width = 10;
+
+    static void encode(const Date& value, unsigned char* out) {
+        detail::store_ordered(value.year, out);
+        out[8] = static_cast<unsigned char>(value.month);
+        out[9] = static_cast<unsigned char>(value.day);
+    }
+};
+
+template <>
+struct sort_key<TimeField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width = 3;
+
+    static void encode(const Time& value, unsigned char* out) {
+        out[0] = static_cast<unsigned char>(value.hour);
+        out[1] = static_cast<unsigned char>(value.minute);
+        out[2] = static_cast<unsigned char>(value.second);
+    }
+};
+
+template <>
+struct sort_key<DateTimeField> {
+    static constexpr bool radix = true;
+    static constexpr size_t width =
+        sort_key<DateField>::width + sort_key<TimeField>::width;
+
+    static void encode(const DateTime& value, unsigned char* out) {
+        sort_key<DateField>::encode(value, out);
+        sort_key<TimeField>::encode(value, out + sort_key<DateField>::width);
+    }
+};
+
+namespace detail {
+
+/**
+ * @brief the tag telling whether the Nth field of an item has a binary key
+ */
+template <size_t N, typename Item>
+using radix_tag =
+    std::integral_constant<bool, sort_key<field_t<N, Item>>::radix>;
+
+template <typename Item>
+constexpr size_t key_width() {
+    return 0;
+}
+
+/**
+ * @brief get the total width of the binary keys of some fields
+ */
+template <typename Item, size_t N, size_t... Ns>
+constexpr size_t key_width() {
+    return sort_key<field_t<N, Item>>::width + key_width<Item, Ns...>();
+}
+
+template <typename Item>
+constexpr bool all_radix() {
+    return true;
+}
+
+/**
+ * @brief check whether every field has a binary key
+ */
+template <typename Item, size_t N, size_t... Ns>
+constexpr bool all_radix() {
+    return sort_key<field_t<N, Item>>::radix && all_radix<Item, Ns...>();
+}
+
+/**
+ * @class SortKeys
+ * @brief the packed binary keys of a list of rows, the fields without a
+ * binary key take no room and are compared on the items themselves
+ * @tparam Item the type of the items
+ * @tparam Ns the indices of the key fields, the most significant first
+ */
+template <typename Item, size_t... Ns>
+class SortKeys {
+public:
+    static constexpr size_t width = key_width<Item, Ns...>();
+    static constexpr bool radix = all_radix<Item, Ns...>();
+
+private:
+    const std::vector<Item>& items_;
+    const std::vector<size_t>& rows_;
+    SortOrder order_;
+    std::vector<unsigned char> keys_;
+
+    template <size_t N>
+    void encode_field(const Item& item, unsigned char* out, std::true_type) {
+        sort_key<field_t<N, Item>>::encode(item.template get_field_value<N>(),
+                                           out);
+    }
+
+    template <size_t N>
+    void encode_field(const Item&, unsigned char*, std::false_type) {}
+
+    void encode(const Item& item, unsigned char* out) {
+        size_t offset = 0;
+        // the braced list evaluates the fields from left to right
+        int order[] = {0, (encode_field<Ns>(item, out + offset,
+                                            radix_tag<Ns, Item>()),
+                           offset += sort_key<field_t<Ns, Item>>::width, 0)...};
+        static_cast<void>(order);
+    }
+
+    template <typename = void>
+    int compare_from(size_t, size_t, size_t) const {
+        return 0;
+    }
+
+    template <size_t N, size_t... Rest>
+    int compare_from(size_t lhs, size_t rhs, size_t offset) const {
+        int res = compare_field<N>(lhs, rhs, offset, radix_tag<N, Item>());
+        if (res != 0) {
+            return res;
+        }
+        return compare_from<Rest...>(
+            lhs, rhs, offset + sort_key<field_t<N, Item>>::width);
+    }
+
+    template <size_t N>
+    int compare_field(size_t lhs, size_t rhs, size_t offset,
+                      std::true_type) const {
+        return std::memcmp(key(lhs) + offset, key(rhs) + offset,
+                           sort_key<field_t<N, Item>>::width);
+    }
+
+    template <size_t N>
+    int compare_field(size_t lhs, size_t rhs, size_t, std::false_type) const {
+        const auto& l = items_[rows_[lhs]].template get_field_value<N>();
+        const auto& r = items_[rows_[rhs]].template get_field_value<N>();
+        int res = l < r ? -1 : (r < l ? 1 : 0);
+        return order_ == SortOrder::Descending ? -res : res;
+    }
+
+public:
+    /**
+     * @brief build the keys of the rows
+     * @param items the items
+     * @param rows the indices of the rows to sort
+     * @param order the order of the sort
+     */
+    SortKeys(const std::vector<Item>& items, const std::vector<size_t>& rows,
+             SortOrder order)
+        : items_(items), rows_(rows), order_(order),
+          keys_(rows.size() * width) {
+        for (size_t i = 0; i < rows_.size(); ++i) {
+            encode(items_[rows_[i]], keys_.data() + i * width);
+        }
+        if (order_ == SortOrder::Descending) {
+            // inverting the bytes reverses the memcmp order
+            for (auto& byte : keys_) {
+                byte = static_cast<unsigned char>(~byte);
+            }
+        }
+    }
+
+    SortKeys(const SortKeys& rhs) = delete;
+    SortKeys& operator=(const SortKeys& rhs) = delete;
+
+    /**
+     * @brief get the binary key of the ith row
+     * @param pos the position of the row in the list
+     * @return the pointer to the key
+     */
+    const unsigned char* key(size_t pos) const {
+        return keys_.data() + pos * width;
+    }
+
+    /**
+     * @brief compare two rows by the key fields
+     * @param lhs the position of the left row in the list
+     * @param rhs the position of the right row in the list
+     * @return negative, zero or positive as lhs sorts before, with or after
+     * rhs
+     */
+    int compare(size_t lhs, size_t rhs) const {
+        return compare_from<Ns...>(lhs, rhs, 0);
+    }
+};
+
+/**
+ * @brief sort positions by their binary keys with a stable LSD radix sort,
+ * the byte positions shared by every key are skipped
+ * @param keys the packed keys
+ * @param width the width of a key
+ * @param positions the positions to sort
+ */
+inline void radix_sort(const unsigned char* keys, size_t width,
+                       std::vector<size_t>& positions) {
+    size_t n = positions.size();
+    if (n < 2) {
+        return;
+    }
+
+    // the histograms of every byte position do not depend on the order
+    std::vector<size_t> counts(width * 256, 0);
+    for (auto pos : positions) {
+        for (size_t b = 0; b < width; ++b) {
+            ++counts[b * 256 + keys[pos * width + b]];
+        }
+    }
+
+    std::vector<size_t> buf(n);
+    for (size_t b = width; b-- > 0;) {
+        size_t* count = counts.data() + b * 256;
+        if (count[keys[positions[0] * width + b]] == n) {
+            continue;
+        }
+        size_t sum = 0;
+        for (size_t k = 0; k < 256; ++k) {
+            size_t c = count[k];
+            count[k] = sum;
+            sum += c;
+        }
+        for (auto pos : positions) {
+            buf[count[keys[pos * width + b]]++] = pos;
+        }
+        positions.swap(buf);
+    }
+}
+
+template <typename Item, size_t... Ns>
+void sort_indices(const std::vector<Item>& items, std::vector<size_t>& rows,
+                  SortOrder order, bool stable) {
+    SortKeys<Item, Ns...> keys(items, rows, order);
+    std::vector<size_t> positions(rows.size());
+    std::iota(positions.begin(), positions.end(), 0);
+
+    if (SortKeys<Item, Ns...>::radix) {
+        radix_sort(keys.key(0), SortKeys<Item, Ns...>::width, positions);
+    } else if (stable) {
+        std::stable_sort(positions.begin(), positions.end(),
+                         [&keys](size_t lhs, size_t rhs) {
+                             return keys.compare(lhs, rhs) < 0;
+                         });
+    } else {
+        std::sort(positions.begin(), positions.end(),
+                  [&keys](size_t lhs, size_t rhs) {
+                      return keys.compare(lhs, rhs) < 0;
+                  });
+    }
+
+    std::vector<size_t> res(rows.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        res[i] = rows[positions[i]];
+    }
+    rows.swap(res);
+}
+} // namespace detail
+
+/**
+ * @brief sort a list of rows by some fields, stable for the fields with
+ * binary keys which are radix sorted
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param rows the indices of the rows to sort, sorted in place
+ * @param order the order of the sort
+ */
+template <size_t... Ns, typename Item>
+void sort_indices_by(const std::vector<Item>& items, std::vector<size_t>& rows,
+                     SortOrder order = SortOrder::Ascending) {
+    detail::sort_indices<Item, Ns...>(items, rows, order, false);
+}
+
+/**
+ * @brief sort a list of rows by some fields, the rows with equal keys keep
+ * their relative order
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param rows the indices of the rows to sort, sorted in place
+ * @param order the order of the sort
+ */
+template <size_t... Ns, typename Item>
+void stable_sort_indices_by(const std::vector<Item>& items,
+                            std::vector<size_t>& rows,
+                            SortOrder order = SortOrder::Ascending) {
+    detail::sort_indices<Item, Ns...>(items, rows, order, true);
+}
+
+/**
+ * @brief move the first k rows of a list in the sort order to its front, the
+ * rows with equal keys keep their relative order, the order of the rest is
+ * unspecified
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param rows the indices of the rows, partially sorted in place
+ * @param k the count of rows to sort
+ * @param order the order of the sort
+ */
+template <size_t... Ns, typename Item>
+void partial_sort_indices_by(const std::vector<Item>& items,
+                             std::vector<size_t>& rows, size_t k,
+                             SortOrder order = SortOrder::Ascending) {
+    k = std::min(k, rows.size());
+    detail::SortKeys<Item, Ns...> keys(items, rows, order);
+    std::vector<size_t> positions(rows.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    // the positions break the ties to keep the sort stable
+    std::partial_sort(positions.begin(), positions.begin() + k,
+                      positions.end(), [&keys](size_t lhs, size_t rhs) {
+                          int res = keys.compare(lhs, rhs);
+                          return res < 0 || (res == 0 && lhs < rhs);
+                      });
+
+    std::vector<size_t> res(rows.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        res[i] = rows[positions[i]];
+    }
+    rows.swap(res);
+}
+
+/**
+ * @brief sort the items by some fields without moving them
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param order the order of the sort
+ * @return the indices of the items in the sort order
+ */
+template <size_t... Ns, typename Item>
+std::vector<size_t> sort_by(const std::vector<Item>& items,
+                            SortOrder order = SortOrder::Ascending) {
+    std::vector<size_t> rows(items.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    sort_indices_by<Ns...>(items, rows, order);
+    return rows;
+}
+
+/**
+ * @brief sort the items by some fields without moving them, the items with
+ * equal keys keep their relative order
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param order the order of the sort
+ * @return the indices of the items in the sort order
+ */
+template <size_t... Ns, typename Item>
+std::vector<size_t> stable_sort_by(const std::vector<Item>& items,
+                                   SortOrder order = SortOrder::Ascending) {
+    std::vector<size_t> rows(items.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    stable_sort_indices_by<Ns...>(items, rows, order);
+    return rows;
+}
+
+/**
+ * @brief get the first k items in the sort order without sorting the rest
+ * @tparam Ns the indices of the key fields, the most significant first
+ * @param items the items
+ * @param k the count of items to get
+ * @param order the order of the sort
+ * @return the indices of the first k items in the sort order
+ */
+template <size_t... Ns, typename Item>
+std::vector<size_t> top_k_by(const std::vector<Item>& items, size_t k,
+                             SortOrder order = SortOrder::Ascending) {
+    std::vector<size_t> rows(items.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    partial_sort_indices_by<Ns...>(items, rows, k, order);
+    rows.resize(std::min(k, rows.size()));
+    return rows;
+}
+} // namespace msf
+#endif
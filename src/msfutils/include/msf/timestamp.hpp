@@ -0,0 +1,319 @@
+#ifndef PMS_TIMESTAMP_HPP
+#define PMS_TIMESTAMP_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <msf/DateTime.hpp>
+#include <msf/types.hpp>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace msf {
+
+namespace detail {
+
+/**
+ * @class TimestampLayout
+ * @brief the description of a fixed-width timestamp format, '0' in the
+ * pattern marks a digit, any other character is a delimiter expected verbatim
+ */
+struct TimestampLayout {
+    // the pattern padded to the width of the scratch buffer
+    char pattern[32];
+    // the width of the format
+    size_t width;
+    // bit i is set if the character i must be a digit
+    std::uint32_t digit_mask;
+    // bit i is set if the character i must be a delimiter
+    std::uint32_t delimiter_mask;
+
+    explicit TimestampLayout(c_string pat)
+        : pattern(), width(std::strlen(pat)), digit_mask(0),
+          delimiter_mask(0) {
+        std::memcpy(pattern, pat, width);
+        for (size_t i = 0; i < width; ++i) {
+            if (pat[i] == '0') {
+                digit_mask |= std::uint32_t(1) << i;
+            } else {
+                delimiter_mask |= std::uint32_t(1) << i;
+            }
+        }
+    }
+};
+
+inline const TimestampLayout& date_layout() {
+    static const TimestampLayout layout("0000-00-00");
+    return layout;
+}
+
+inline const TimestampLayout& time_layout() {
+    static const TimestampLayout layout("00:00:00");
+    return layout;
+}
+
+inline const TimestampLayout& date_time_layout() {
+    static const TimestampLayout layout("0000-00-00 00:00:00");
+    return layout;
+}
+
+/**
+ * @brief check that the buffer matches the layout, with SSE2 a whole 16-byte
+ * half of the buffer is checked by a handful of instructions
+ * @param buf the 32-byte scratch buffer holding the string
+ * @param layout the layout to match
+ * @return true if every digit position holds a digit and every delimiter
+ * position holds the expected delimiter
+ */
+inline bool match_layout(const unsigned char* buf,
+                         const TimestampLayout& layout) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ascii_zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    std::uint32_t digits = 0;
+    std::uint32_t delimiters = 0;
+    for (size_t half = 0; half * 16 < layout.width; ++half) {
+        __m128i chars = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(buf + half * 16));
+        __m128i expected = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(layout.pattern + half * 16));
+        // a character is a digit if (c - '0') saturates to 0 after - 9
+        __m128i offset = _mm_sub_epi8(chars, ascii_zero);
+        __m128i is_digit =
+            _mm_cmpeq_epi8(_mm_subs_epu8(offset, nine), zero);
+        __m128i is_delimiter = _mm_cmpeq_epi8(chars, expected);
+        digits |= static_cast<std::uint32_t>(_mm_movemask_epi8(is_digit))
+            << (half * 16);
+        delimiters |=
+            static_cast<std::uint32_t>(_mm_movemask_epi8(is_delimiter))
+            << (half * 16);
+    }
+    return (digits & layout.digit_mask) == layout.digit_mask &&
+        (delimiters & layout.delimiter_mask) == layout.delimiter_mask;
+#else
+    for (size_t i = 0; i < layout.width; ++i) {
+        if (layout.pattern[i] == '0') {
+            if (static_cast<unsigned char>(buf[i] - '0') > 9) {
+                return false;
+            }
+        } else if (buf[i] != static_cast<unsigned char>(layout.pattern[i])) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+/**
+ * @brief convert 8 characters to the two-digit numbers starting at each of
+ * them with a single multiply-add, byte k of the result holds
+ * 10 * d[k] + d[k + 1], byte 7 is incomplete and must not be used
+ * @param p the pointer to the 8 characters
+ * @return the packed two-digit numbers
+ */
+inline std::uint64_t two_digit_lanes(const unsigned char* p) {
+    std::uint64_t word = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        word |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    }
+    // keeping the low nibble maps digits to their values without borrows
+    word &= 0x0F0F0F0F0F0F0F0FULL;
+    return word * 10 + (word >> 8);
+}
+
+/**
+ * @brief get the two-digit number starting at a position of the buffer
+ * @param lanes the result of two_digit_lanes() for every 8-byte word
+ * @param pos the position of the first digit, pos % 8 must not be 7
+ * @return the two-digit number
+ */
+inline Integer two_digits_at(const std::uint64_t* lanes, size_t pos) {
+    return static_cast<Integer>((lanes[pos / 8] >> (8 * (pos % 8))) & 0xFF);
+}
+
+inline bool convert_date(const unsigned char* buf, Date& out) {
+    std::uint64_t lanes[2] = {two_digit_lanes(buf), two_digit_lanes(buf + 8)};
+    Integer y = two_digits_at(lanes, 0) * 100 + two_digits_at(lanes, 2);
+    Integer m = two_digits_at(lanes, 5);
+    Integer d = two_digits_at(lanes, 8);
+    if (!Date::is_valid(y, m, d)) {
+        return false;
+    }
+    out.year = y;
+    out.month = m;
+    out.day = d;
+    return true;
+}
+
+inline bool convert_time(const unsigned char* buf, Time& out) {
+    std::uint64_t lanes[1] = {two_digit_lanes(buf)};
+    Integer h = two_digits_at(lanes, 0);
+    Integer m = two_digits_at(lanes, 3);
+    Integer s = two_digits_at(lanes, 6);
+    if (!Time::is_valid(h, m, s)) {
+        return false;
+    }
+    out.hour = h;
+    out.minute = m;
+    out.second = s;
+    return true;
+}
+
+inline bool convert_date_time(const unsigned char* buf, DateTime& out) {
+    std::uint64_t lanes[3] = {two_digit_lanes(buf), two_digit_lanes(buf + 8),
+                              two_digit_lanes(buf + 16)};
+    Integer y = two_digits_at(lanes, 0) * 100 + two_digits_at(lanes, 2);
+    Integer mon = two_digits_at(lanes, 5);
+    Integer d = two_digits_at(lanes, 8);
+    Integer h = two_digits_at(lanes, 11);
+    Integer min = two_digits_at(lanes, 14);
+    Integer s = two_digits_at(lanes, 17);
+    if (!Date::is_valid(y, mon, d) || !Time::is_valid(h, min, s)) {
+        return false;
+    }
+    out.year = y;
+    out.month = mon;
+    out.day = d;
+    out.hour = h;
+    out.minute = min;
+    out.second = s;
+    return true;
+}
+
+/**
+ * @brief the common loop of the batch parsers
+ * @param strs the strings to parse
+ * @param count the count of the strings
+ * @param out the array to receive the values
+ * @param errors the error bitmap, bit i is set if strs[i] is rejected
+ * @param layout the layout of the format
+ * @param convert the function converting a matched buffer to a value
+ * @return the count of rejected strings
+ */
+template <typename T, typename Convert>
+size_t parse_batch(const string* strs, size_t count, T* out,
+                   std::uint64_t* errors, const TimestampLayout& layout,
+                   Convert convert) {
+    // the bytes beyond the width stay zero, so the loads never see garbage
+    alignas(16) unsigned char buf[32] = {};
+    size_t error_count = 0;
+    for (size_t word = 0; word * 64 < count; ++word) {
+        errors[word] = 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        bool ok = strs[i].size() == layout.width;
+        if (ok) {
+            std::memcpy(buf, strs[i].data(), layout.width);
+            ok = match_layout(buf, layout) && convert(buf, out[i]);
+        }
+        if (!ok) {
+            errors[i / 64] |= std::uint64_t(1) << (i % 64);
+            ++error_count;
+        }
+    }
+    return error_count;
+}
+} // namespace detail
+
+/**
+ * @brief get the count of 64-bit words of the error bitmap for a batch
+ * @param count the count of the strings in the batch
+ * @return the count of words
+ */
+constexpr size_t error_bitmap_size(size_t count) {
+    return (count + 63) / 64;
+}
+
+/**
+ * @brief check whether the ith string of a batch is rejected
+ * @param errors the error bitmap filled by the batch parser
+ * @param idx the index of the string
+ * @return true if the string is rejected
+ */
+inline bool has_error(const std::uint64_t* errors, size_t idx) {
+    return (errors[idx / 64] >> (idx % 64)) & 1;
+}
+
+/**
+ * @brief parse a block of "YYYY-MM-DD" dates, the strings are validated with
+ * the same checks as the Date constructor but nothing is thrown
+ * @param strs the strings to parse
+ * @param count the count of the strings
+ * @param out the array to receive the dates, rejected entries are untouched
+ * @param errors the error bitmap of error_bitmap_size(count) words
+ * @return the count of rejected strings
+ */
+inline size_t parse_dates(const string* strs, size_t count, Date* out,
+                          std::uint64_t* errors) {
+    return detail::parse_batch(strs, count, out, errors, detail::date_layout(),
+                               detail::convert_date);
+}
+
+/**
+ * @brief parse a block of "hh:mm:ss" times, the strings are validated with
+ * the same checks as the Time constructor but nothing is thrown
+ * @param strs the strings to parse
+ * @param count the count of the strings
+ * @param out the array to receive the times, rejected entries are untouched
+ * @param errors the error bitmap of error_bitmap_size(count) words
+ * @return the count of rejected strings
+ */
+inline size_t parse_times(const string* strs, size_t count, Time* out,
+                          std::uint64_t* errors) {
+    return detail::parse_batch(strs, count, out, errors, detail::time_layout(),
+                               detail::convert_time);
+}
+
+/**
+ * @brief parse a block of "YYYY-MM-DD hh:mm:ss" date times, the strings are
+ * validated with the same checks as the DateTime constructor but nothing is
+ * thrown
+ * @param strs the strings to parse
+ * @param count the count of the strings
+ * @param out the array to receive the date times, rejected entries are
+ * untouched
+ * @param errors the error bitmap of error_bitmap_size(count) words
+ * @return the count of rejected strings
+ */
+inline size_t parse_date_times(const string* strs, size_t count,
+                               DateTime* out, std::uint64_t* errors) {
+    return detail::parse_batch(strs, count, out, errors,
+                               detail::date_time_layout(),
+                               detail::convert_date_time);
+}
+
+/**
+ * @brief parse a single "YYYY-MM-DD" date without throwing
+ * @param str the string to parse
+ * @param out the date to receive the value
+ * @return true if the string is accepted
+ */
+inline bool try_parse_date(const string& str, Date& out) {
+    std::uint64_t error;
+    return parse_dates(&str, 1, &out, &error) == 0;
+}
+
+/**
+ * @brief parse a single "hh:mm:ss" time without throwing
+ * @param str the string to parse
+ * @param out the time to receive the value
+ * @return true if the string is accepted
+ */
+inline bool try_parse_time(const string& str, Time& out) {
+    std::uint64_t error;
+    return parse_times(&str, 1, &out, &error) == 0;
+}
+
+/**
+ * @brief parse a single "YYYY-MM-DD hh:mm:ss" date time without throwing
+ * @param str the string to parse
+ * @param out the date time to receive the value
+ * @return true if the string is accepted
+ */
+inline bool try_parse_date_time(const string& str, DateTime& out) {
+    std::uint64_t error;
+    return parse_date_times(&str, 1, &out, &error) == 0;
+}
+} // namespace msf
+#endif
@@ -0,0 +1,59 @@
+#ifndef PMS_TESTS_STUDENTS_HPP
+#define PMS_TESTS_STUDENTS_HPP
+
+#include <array>
+#include <msf/BasicItem.hpp>
+#include <msf/DateTime.hpp>
+#include <msf/fields.hpp>
+#include <msf/types.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @class Student
+ * @brief the item shared by the tests of the collections
+ */
+class Student
+    : public msf::BasicItem<6, msf::IntegerField, msf::TextField,
+                            msf::BooleanField, msf::FloatField, msf::DateField,
+                            msf::DateTimeField> {
+public:
+    using BasicItem::BasicItem;
+
+    static constexpr std::array<msf::c_string, 6> get_field_names() {
+        return {{"student_id", "name", "in_reading", "score", "admision_date",
+                 "admision_time"}};
+    }
+};
+
+/**
+ * @brief make the students of the tests, the student i has
+ * - the id i and the name "student" followed by i * 37
+ * - in_reading set for every third student from the first
+ * - the score (i * 7919 % 1000) / 4, distinct for the first 1000 students
+ * - the admission date 2024-08-25 plus i / 3 days, in runs of three
+ * - the admission time 2024-08-25 00:00:00 plus i * 10807 seconds
+ * @param count the count of students
+ * @return the students in the order of their ids
+ */
+inline std::vector<Student> make_students(size_t count) {
+    const msf::Date first_date(2024, 8, 25);
+    const msf::Integer first_time =
+        msf::DateTime(2024, 8, 25, 0, 0, 0).seconds_since_epoch();
+    std::vector<Student> students;
+    students.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        msf::Integer id = static_cast<msf::Integer>(i);
+        students.emplace_back(
+            msf::IntegerField(id),
+            msf::TextField("student" + std::to_string(id * 37)),
+            msf::BooleanField(i % 3 == 0),
+            msf::FloatField(static_cast<double>(id * 7919 % 1000) / 4),
+            msf::DateField(msf::Date::from_days_since_epoch(
+                first_date.days_since_epoch() + id / 3)),
+            msf::DateTimeField(msf::DateTime::from_seconds_since_epoch(
+                first_time + id * 10807)));
+    }
+    return students;
+}
+#endif
@@ -0,0 +1,181 @@
+#include "students.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <msf/ArrowWriter.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+/**
+ * @brief a reader of the flatbuffers tables written by the Arrow writer
+ */
+class FlatTable {
+private:
+    const std::string* buf_;
+    size_t pos_;
+
+public:
+    FlatTable(const std::string& buf, size_t pos) : buf_(&buf), pos_(pos) {}
+
+    static std::uint64_t read(const std::string& buf, size_t pos,
+                              size_t bytes) {
+        return BinaryReader(buf.data() + pos, bytes).read_unsigned(bytes);
+    }
+
+    static FlatTable root(const std::string& buf, size_t start) {
+        return FlatTable(buf, start + read(buf, start, 4));
+    }
+
+    size_t field(unsigned id) const {
+        size_t vtable = pos_ - std::int32_t(read(*buf_, pos_, 4));
+        if (4 + 2 * id >= read(*buf_, vtable, 2)) {
+            return 0;
+        }
+        size_t offset = read(*buf_, vtable + 4 + 2 * id, 2);
+        return offset == 0 ? 0 : pos_ + offset;
+    }
+
+    std::uint64_t scalar(unsigned id, size_t bytes) const {
+        return read(*buf_, field(id), bytes);
+    }
+
+    size_t target(unsigned id) const {
+        size_t pos = field(id);
+        return pos + read(*buf_, pos, 4);
+    }
+
+    FlatTable table(unsigned id) const {
+        return FlatTable(*buf_, target(id));
+    }
+};
+
+TEST(TestLayout, TestArrowWriter) {
+    auto students = make_students(1000);
+    std::ostringstream out;
+    write_arrow(out, students, 300);
+    std::string file = out.str();
+
+    ASSERT_EQ(file.substr(0, 8), std::string("ARROW1\0\0", 8));
+    ASSERT_EQ(file.substr(file.size() - 6), "ARROW1");
+    size_t footer_size = FlatTable::read(file, file.size() - 10, 4);
+    size_t footer_start = file.size() - 10 - footer_size;
+    ASSERT_EQ(footer_start % 8, 0);
+    // the end of the stream
+    ASSERT_EQ(FlatTable::read(file, footer_start - 8, 8), 0xFFFFFFFF);
+
+    FlatTable footer = FlatTable::root(file, footer_start);
+    ASSERT_EQ(footer.scalar(0, 2), 4);
+    size_t blocks = footer.target(3);
+    ASSERT_EQ(FlatTable::read(file, blocks, 4), 4);
+
+    std::vector<Integer> values;
+    std::vector<bool> flags;
+    std::string text;
+    for (size_t i = 0; i < 4; ++i) {
+        size_t block = blocks + 4 + 24 * i;
+        size_t offset = FlatTable::read(file, block, 8);
+        size_t metadata_length = FlatTable::read(file, block + 8, 4);
+        size_t body_length = FlatTable::read(file, block + 16, 8);
+        ASSERT_EQ(offset % 8, 0);
+        ASSERT_EQ(FlatTable::read(file, offset, 4), 0xFFFFFFFF);
+        ASSERT_EQ(FlatTable::read(file, offset + 4, 4) + 8, metadata_length);
+
+        FlatTable message = FlatTable::root(file, offset + 8);
+        ASSERT_EQ(message.scalar(1, 1), 3);
+        ASSERT_EQ(message.scalar(3, 8), body_length);
+        FlatTable batch = message.table(2);
+        size_t rows = batch.scalar(0, 8);
+        ASSERT_EQ(rows, i == 3 ? 100 : 300);
+
+        // the validity and the values of the columns, and the offsets of the
+        // text
+        size_t buffers = batch.target(2);
+        ASSERT_EQ(FlatTable::read(file, buffers, 4), 13);
+        size_t body = offset + metadata_length;
+        auto buffer = [&](size_t idx) {
+            size_t pos = buffers + 4 + 16 * idx;
+            return std::make_pair(body + FlatTable::read(file, pos, 8),
+                                  FlatTable::read(file, pos + 8, 8));
+        };
+        ASSERT_EQ(buffer(0).second, 0);
+        ASSERT_EQ(buffer(1).second, rows * 8);
+        for (size_t row = 0; row < rows; ++row) {
+            values.push_back(FlatTable::read(file, buffer(1).first + 8 * row,
+                                             8));
+            flags.push_back(
+                FlatTable::read(file, buffer(6).first + row / 8, 1) >>
+                    (row % 8) &
+                1);
+        }
+        text.append(file, buffer(4).first, buffer(4).second);
+        ASSERT_EQ(FlatTable::read(file, buffer(3).first + 4 * rows, 4),
+                  buffer(4).second);
+        ASSERT_EQ(buffer(8).second, rows * 8);
+        ASSERT_EQ(buffer(10).second, rows * 4);
+        ASSERT_EQ(buffer(12).second, rows * 8);
+    }
+
+    std::string expected;
+    for (size_t i = 0; i < students.size(); ++i) {
+        ASSERT_EQ(values.at(i), students.at(i).get_field_value<0>());
+        ASSERT_EQ(flags.at(i), students.at(i).get_field_value<2>());
+        expected += students.at(i).get_field_value<1>();
+    }
+    ASSERT_EQ(text, expected);
+}
+
+TEST(TestSchema, TestArrowWriter) {
+    std::ostringstream out;
+    write_arrow(out, make_students(1));
+    std::string file = out.str();
+
+    size_t footer_size = FlatTable::read(file, file.size() - 10, 4);
+    FlatTable footer =
+        FlatTable::root(file, file.size() - 10 - footer_size);
+    FlatTable schema = footer.table(1);
+    size_t fields = schema.target(1);
+    ASSERT_EQ(FlatTable::read(file, fields, 4), 6);
+
+    size_t last = fields + 24 + FlatTable::read(file, fields + 24, 4);
+    FlatTable field(file, last);
+    size_t name = field.target(0);
+    ASSERT_EQ(file.substr(name + 4, FlatTable::read(file, name, 4)),
+              "admision_time");
+    // a timestamp in seconds
+    ASSERT_EQ(field.scalar(2, 1), 10);
+    ASSERT_EQ(field.table(3).scalar(0, 2), 0);
+
+    size_t metadata = field.target(6);
+    size_t pair = metadata + 4 + FlatTable::read(file, metadata + 4, 4);
+    size_t value = FlatTable(file, pair).target(1);
+    ASSERT_EQ(file.substr(value + 4, FlatTable::read(file, value, 4)),
+              "DateTime");
+}
+
+TEST(TestIncremental, TestArrowWriter) {
+    auto students = make_students(250);
+    std::ostringstream whole;
+    write_arrow(whole, students, 64);
+
+    std::ostringstream pieces;
+    ArrowWriter<Student> writer(pieces, 64);
+    for (size_t i = 0; i < 10; ++i) {
+        writer.write(students.at(i));
+    }
+    writer.write(std::vector<Student>(students.cbegin() + 10,
+                                      students.cbegin() + 200));
+    for (size_t i = 200; i < students.size(); ++i) {
+        writer.write(students.at(i));
+    }
+    writer.close();
+    ASSERT_EQ(writer.batch_count(), 4);
+    ASSERT_EQ(pieces.str(), whole.str());
+    ASSERT_THROW(writer.write(students.at(0)), std::runtime_error);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
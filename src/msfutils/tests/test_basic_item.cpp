@@ -59,6 +59,8 @@ public:
     }
 };
 
+constexpr array<c_string, Student::get_field_count()> Student::field_names;
+
 arr<c_string> field_names({"name", "in_reading", "admision_time", "student_id",
                            "education_system"});
 DateField df(Date(2024, 9, 1));
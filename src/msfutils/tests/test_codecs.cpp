@@ -0,0 +1,132 @@
+#include "students.hpp"
+#include <gtest/gtest.h>
+#include <limits>
+#include <msf/BasicItem.hpp>
+#include <msf/codecs.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+TEST(TestIntegerColumn, TestCodecs) {
+    std::vector<Integer> values;
+    // a sorted block, a narrow unsorted block and a block spanning all bits
+    for (Integer i = 0; i < 100; ++i) {
+        values.push_back(1000000 + i * 7);
+    }
+    for (Integer i = 0; i < 100; ++i) {
+        values.push_back((i % 2 ? 50 : -50) + i % 7);
+    }
+    values.push_back(std::numeric_limits<Integer>::min());
+    values.push_back(std::numeric_limits<Integer>::max());
+    values.push_back(0);
+
+    IntegerColumn column(values, 100);
+    ASSERT_EQ(column.size(), values.size());
+    ASSERT_EQ(column.block_count(), 3);
+    ASSERT_EQ(column.block_encoding(0), IntegerEncoding::Delta);
+    ASSERT_EQ(column.block_bits(0), 4);
+    ASSERT_EQ(column.block_encoding(1), IntegerEncoding::FrameOfReference);
+    ASSERT_EQ(column.block_bits(1), 7);
+    ASSERT_EQ(column.block_bits(2), 64);
+    ASSERT_EQ(column.block_min(1), -50);
+    ASSERT_EQ(column.block_max(1), 56);
+
+    ASSERT_EQ(column.decode(), values);
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(column.at(i), values.at(i));
+    }
+    ASSERT_LT(column.compressed_bytes(), values.size() * sizeof(Integer));
+
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values.at(i) >= -10 && values.at(i) <= 1000014) {
+            expected.push_back(i);
+        }
+    }
+    ASSERT_EQ(column.select_range(-10, 1000014), expected);
+}
+
+TEST(TestDateTimeColumn, TestCodecs) {
+    auto students = make_students(300);
+    auto column = compress_column<5>(students);
+    ASSERT_EQ(column.size(), students.size());
+    ASSERT_LT(column.compressed_bytes(), students.size() * sizeof(Integer));
+
+    std::vector<DateTime> block(column.block_size());
+    ASSERT_EQ(column.decode_block(2, block.data()), 44);
+    ASSERT_EQ(block.at(0), students.at(256).get_field_value<5>());
+    ASSERT_EQ(block.at(43), students.at(299).get_field_value<5>());
+    ASSERT_EQ(column.at(299), students.at(299).get_field_value<5>());
+    ASSERT_EQ(column.decode().at(150), students.at(150).get_field_value<5>());
+
+    auto rows = column.select_range(students.at(10).get_field_value<5>(),
+                                    students.at(20).get_field_value<5>());
+    ASSERT_EQ(rows.size(), 11);
+    ASSERT_EQ(rows.front(), 10);
+}
+
+TEST(TestBooleanColumn, TestCodecs) {
+    auto students = make_students(130);
+    auto column = compress_column<2>(students);
+    ASSERT_EQ(column.size(), 130);
+    ASSERT_EQ(column.block_count(), 3);
+    ASSERT_EQ(column.count(), 44);
+
+    auto rows = column.select(true);
+    ASSERT_EQ(rows.size(), 44);
+    for (auto row : rows) {
+        ASSERT_EQ(row % 3, 0);
+        ASSERT_TRUE(column.at(row));
+    }
+    ASSERT_EQ(column.select(false).size(), 86);
+
+    bool block[64];
+    ASSERT_EQ(column.decode_block(2, block), 2);
+    ASSERT_FALSE(block[0]);
+    ASSERT_TRUE(block[1]);
+    ASSERT_THROW(column.decode_block(3, block), std::out_of_range);
+}
+
+TEST(TestRunLengthColumn, TestCodecs) {
+    auto students = make_students(100);
+    auto column = compress_runs<4>(students);
+    ASSERT_EQ(column.size(), 100);
+    ASSERT_EQ(column.run_count(), 34);
+    ASSERT_EQ(column.at(50), Date(2024, 9, 10));
+
+    auto range = column.equal_range(Date(2024, 9, 10));
+    ASSERT_EQ(range.first, 48);
+    ASSERT_EQ(range.second, 51);
+    range = column.equal_range(Date(2025, 1, 1));
+    ASSERT_EQ(range.first, range.second);
+    ASSERT_EQ(range.first, 100);
+
+    std::vector<Date> block(column.block_size());
+    ASSERT_EQ(column.decode_block(0, block.data()), 100);
+    for (size_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(block.at(i), students.at(i).get_field_value<4>());
+    }
+    ASSERT_THROW(column.decode_block(1, block.data()), std::out_of_range);
+    ASSERT_THROW(column.at(100), std::out_of_range);
+
+    size_t runs = 0;
+    column.for_each_run([&](const Date& value, size_t first, size_t count) {
+        ASSERT_EQ(value, students.at(first).get_field_value<4>());
+        // the last run holds the 100th student alone
+        ASSERT_EQ(count, first == 99 ? 1 : 3);
+        ++runs;
+    });
+    ASSERT_EQ(runs, column.run_count());
+
+    std::vector<string> names = {"a", "a", "b", "c", "c", "c"};
+    RunLengthColumn<string> text(names, 4);
+    ASSERT_EQ(text.run_count(), 3);
+    ASSERT_EQ(text.decode(), names);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
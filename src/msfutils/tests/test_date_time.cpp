@@ -28,6 +28,26 @@ TEST(TestComp, TestDateTime) {
     ASSERT_TRUE(dt2 < dt3);
 }
 
+TEST(TestEpoch, TestDateTime) {
+    ASSERT_EQ(msf::Date(1970, 1, 1).days_since_epoch(), 0);
+    ASSERT_EQ(msf::Date(2000, 3, 1).days_since_epoch(), 11017);
+    ASSERT_EQ(msf::Date(1969, 12, 31).days_since_epoch(), -1);
+    ASSERT_EQ(msf::Date::from_days_since_epoch(11016),
+              msf::Date(2000, 2, 29));
+
+    for (msf::Integer days = -800000; days < 800000; days += 997) {
+        msf::Date date = msf::Date::from_days_since_epoch(days);
+        ASSERT_TRUE(msf::Date::is_valid(date.year, date.month, date.day));
+        ASSERT_EQ(date.days_since_epoch(), days);
+    }
+
+    msf::DateTime dt(2024, 12, 25, 0, 21, 24);
+    ASSERT_EQ(dt.seconds_since_epoch(), 1735086084);
+    ASSERT_EQ(msf::DateTime::from_seconds_since_epoch(1735086084), dt);
+    ASSERT_EQ(msf::DateTime::from_seconds_since_epoch(-1),
+              msf::DateTime(1969, 12, 31, 23, 59, 59));
+}
+
 int main() {
     ::testing::InitGoogleTest();
     return RUN_ALL_TESTS();
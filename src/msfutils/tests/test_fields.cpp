@@ -78,6 +78,9 @@ TEST(TestFieldConstructor, TestFields) {
     ASSERT_EQ(new_field_i.value(), field_i.value());
     ASSERT_EQ(new_field_f.value(), field_f.value());
     ASSERT_EQ(new_field_b.value(), field_b.value());
+    ASSERT_EQ(new_field_dt.value(), field_dt.value());
+    ASSERT_EQ(msf::DateTimeField("2024-09-01 13:05:09").value(),
+              msf::DateTime(2024, 9, 1, 13, 5, 9));
 }
 
 int main() {
@@ -0,0 +1,129 @@
+#include "students.hpp"
+#include <gtest/gtest.h>
+#include <msf/filter.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+TEST(TestFilter, TestEvaluate) {
+    auto students = make_students(60);
+    auto filter = compile_filter<Student>(
+        "in_reading = true and admision_time >= 2024-08-30");
+    auto manual = [](const Student& s) {
+        return s.get_field_value<2>() &&
+            !(s.get_field_value<5>() < DateTime(2024, 8, 30, 0, 0, 0));
+    };
+    size_t passed = 0;
+    for (const auto& student : students) {
+        ASSERT_EQ(filter(student), manual(student));
+        passed += manual(student);
+    }
+    ASSERT_GT(passed, 0u);
+    ASSERT_LT(passed, students.size());
+
+    Filter<Student> nested("NOT (student_id < 10 OR student_id >= 50) and "
+                           "(name == 'student555' or score <= 30)");
+    auto rows = filter_rows(students, nested);
+    std::vector<size_t> expected;
+    for (size_t row = 0; row < students.size(); ++row) {
+        Integer id = students[row].get_field_value<0>();
+        if (id >= 10 && id < 50 &&
+            (id == 15 || students[row].get_field_value<3>() <= 30)) {
+            expected.push_back(row);
+        }
+    }
+    ASSERT_EQ(rows, expected);
+    ASSERT_EQ(rows, std::vector<size_t>({11, 12, 15, 24, 36, 37, 48, 49}));
+
+    Filter<Student> bare("in_reading and student_id != 3");
+    ASSERT_TRUE(bare(students[0]));
+    ASSERT_FALSE(bare(students[3]));
+    ASSERT_FALSE(bare(students[4]));
+
+    Filter<Student> exact("admision_time = \"2024-08-25 06:00:14\"");
+    ASSERT_EQ(filter_rows(students, exact), std::vector<size_t> {2});
+
+    Filter<Student> day("admision_date = 2024-08-26");
+    ASSERT_EQ(filter_rows(students, day), std::vector<size_t>({3, 4, 5}));
+}
+
+TEST(TestFilter, TestFolding) {
+    auto students = make_students(60);
+    bool value = false;
+    Filter<Student> always("true or student_id > 3");
+    ASSERT_TRUE(always.is_constant(value));
+    ASSERT_TRUE(value);
+
+    Filter<Student> never("student_id > 3 and not true");
+    ASSERT_TRUE(never.is_constant(value));
+    ASSERT_FALSE(value);
+    ASSERT_TRUE(filter_rows(students, never).empty());
+
+    Filter<Student> reduced("false or (true and student_id > 3)");
+    ASSERT_FALSE(reduced.is_constant(value));
+    ASSERT_EQ(filter_rows(students, reduced).size(), 56u);
+
+    Filter<Student> twice("not not student_id > 3");
+    ASSERT_EQ(filter_rows(students, twice).size(), 56u);
+}
+
+TEST(TestFilter, TestErrors) {
+    ASSERT_THROW(Filter<Student>("age > 3"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("student_id > three"),
+                 std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("in_reading = yes"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("admision_time > 2024-13-01"),
+                 std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("student_id"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("student_id => 3"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("(student_id > 3"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("student_id > 3 student_id < 5"),
+                 std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("name = 'student"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>(""), std::invalid_argument);
+
+    // the literals must be read to their end
+    ASSERT_THROW(Filter<Student>("student_id >= 3.5"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("student_id = 3abc"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("score < 1.5x"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("admision_date = 2024-08-26x"),
+                 std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("admision_time = '2024-08-25 06:00:14 x'"),
+                 std::invalid_argument);
+    ASSERT_NO_THROW(Filter<Student>("score < ' 1.5 '"));
+
+    // the constants are spelled as the Boolean literals
+    ASSERT_THROW(Filter<Student>("in_reading = TRUE"), std::invalid_argument);
+    ASSERT_THROW(Filter<Student>("TRUE or student_id < 3"),
+                 std::invalid_argument);
+    ASSERT_NO_THROW(Filter<Student>("NOT in_reading = true OR false"));
+
+    // a deep nesting is rejected before it exhausts the stack
+    std::string deep(30000, '(');
+    deep += "in_reading" + std::string(30000, ')');
+    ASSERT_THROW((Filter<Student>(deep)), std::invalid_argument);
+    std::string negations;
+    for (size_t i = 0; i < 30000; ++i) {
+        negations += "not (";
+    }
+    negations += "in_reading" + std::string(30000, ')');
+    ASSERT_THROW((Filter<Student>(negations)), std::invalid_argument);
+    std::string allowed(128, '(');
+    allowed += "not in_reading" + std::string(128, ')');
+    ASSERT_NO_THROW((Filter<Student>(allowed)));
+
+    try {
+        Filter<Student>("student_id > 3 and score < high");
+        FAIL();
+    } catch (const std::invalid_argument& e) {
+        ASSERT_EQ(std::string(e.what()),
+                  "invalid Float literal high for field score in filter");
+    }
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <msf/BasicItem.hpp>
+#include <msf/ItemPool.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+using Record = BasicItem<2, TextField, IntegerField>;
+
+TEST(TestHandles, TestItemPool) {
+    ItemPool<Record> pool;
+    std::vector<ItemPool<Record>::handle_type> handles;
+    for (Integer i = 0; i < 1000; ++i) {
+        handles.push_back(
+            pool.emplace(TextField(std::to_string(i)), IntegerField(i)));
+    }
+    ASSERT_EQ(pool.size(), 1000);
+    ASSERT_EQ(pool.capacity(), 1024);
+
+    // the items do not move while the pool grows
+    const Record* first = pool.get(handles.at(0));
+    for (Integer i = 0; i < 1000; ++i) {
+        ASSERT_EQ(pool.at(handles.at(i)).get_field_value<1>(), i);
+    }
+    ASSERT_EQ(pool.get(handles.at(0)), first);
+
+    ASSERT_TRUE(pool.erase(handles.at(10)));
+    ASSERT_FALSE(pool.erase(handles.at(10)));
+    ASSERT_FALSE(pool.contains(handles.at(10)));
+    ASSERT_EQ(pool.get(handles.at(10)), nullptr);
+    ASSERT_THROW(pool.at(handles.at(10)), std::out_of_range);
+    ASSERT_EQ(pool.size(), 999);
+
+    // the slot is reused with a new generation
+    auto reused = pool.insert(Record(TextField("new"), IntegerField(-1)));
+    ASSERT_NE(reused, handles.at(10));
+    ASSERT_FALSE(pool.contains(handles.at(10)));
+    ASSERT_EQ(pool.at(reused).get_field_value<0>(), "new");
+    ASSERT_EQ(pool.capacity(), 1024);
+    ASSERT_FALSE(pool.contains(ItemPool<Record>::null_handle));
+}
+
+TEST(TestDenseIteration, TestItemPool) {
+    ItemPool<Record, std::uint32_t, 16> pool;
+    std::vector<std::uint32_t> handles;
+    for (Integer i = 0; i < 100; ++i) {
+        handles.push_back(pool.emplace(TextField("x"), IntegerField(i)));
+    }
+    for (Integer i = 0; i < 100; i += 3) {
+        pool.erase(handles.at(i));
+    }
+
+    std::set<Integer> seen;
+    for (const auto& item : pool) {
+        seen.insert(item.get_field_value<1>());
+    }
+    ASSERT_EQ(seen.size(), pool.size());
+    ASSERT_EQ(seen.size(), 66);
+    ASSERT_EQ(seen.count(3), 0);
+
+    size_t visited = 0;
+    pool.for_each([&](std::uint32_t handle, Record& item) {
+        ASSERT_EQ(pool.get(handle), &item);
+        item.get_field_value<1>() *= 2;
+        ++visited;
+    });
+    ASSERT_EQ(visited, 66);
+    ASSERT_EQ(pool.at(handles.at(1)).get_field_value<1>(), 2);
+}
+
+TEST(TestClear, TestItemPool) {
+    auto counter = std::make_shared<int>(0);
+    using Holder = std::shared_ptr<int>;
+    {
+        ItemPool<Holder> pool;
+        std::vector<std::uint64_t> handles;
+        for (int i = 0; i < 10; ++i) {
+            handles.push_back(pool.emplace(counter));
+        }
+        ASSERT_EQ(counter.use_count(), 11);
+
+        pool.clear();
+        ASSERT_TRUE(pool.empty());
+        for (auto handle : handles) {
+            ASSERT_FALSE(pool.contains(handle));
+        }
+        // destroyed lazily when the slots are reused
+        ASSERT_EQ(counter.use_count(), 11);
+
+        auto handle = pool.emplace(counter);
+        ASSERT_FALSE(pool.contains(handles.at(0)));
+        ASSERT_TRUE(pool.contains(handle));
+        ASSERT_EQ(counter.use_count(), 11);
+        ASSERT_EQ(pool.size(), 1);
+
+        // the live item is kept
+        pool.release();
+        ASSERT_EQ(counter.use_count(), 2);
+        ASSERT_TRUE(pool.contains(handle));
+    }
+    ASSERT_EQ(counter.use_count(), 1);
+
+    ItemPool<Record> records;
+    records.emplace(TextField(std::string(100, 'x')), IntegerField(0));
+    records.clear();
+    size_t cleared = records.memory_usage().heap_bytes;
+    records.release();
+    ASSERT_GE(cleared - records.memory_usage().heap_bytes, 101);
+}
+
+TEST(TestRetirement, TestItemPool) {
+    ItemPool<Record, std::uint32_t, 16> pool;
+    auto first = pool.emplace(TextField("first"), IntegerField(0));
+    std::set<std::uint32_t> handles = {first};
+    pool.erase(first);
+
+    // the slot holds 4095 items, every handle is new
+    for (Integer i = 1; i < 4095; ++i) {
+        auto handle = pool.emplace(TextField("x"), IntegerField(i));
+        ASSERT_EQ(handle & 0xFFFFF, 0);
+        ASSERT_TRUE(handles.insert(handle).second);
+        pool.erase(handle);
+    }
+    auto next = pool.emplace(TextField("next"), IntegerField(-1));
+    ASSERT_EQ(next & 0xFFFFF, 1);
+    for (auto handle : handles) {
+        ASSERT_FALSE(pool.contains(handle));
+    }
+
+    // the retired slot is not reused after clear() either
+    pool.clear();
+    ASSERT_EQ(pool.emplace(TextField("y"), IntegerField(1)) & 0xFFFFF, 1);
+}
+
+TEST(TestMove, TestItemPool) {
+    auto counter = std::make_shared<int>(0);
+    using Holder = std::shared_ptr<int>;
+    ItemPool<Holder> pool;
+    auto handle = pool.emplace(counter);
+    pool.emplace(counter);
+
+    ItemPool<Holder> moved(std::move(pool));
+    ASSERT_EQ(moved.size(), 2);
+    ASSERT_EQ(moved.at(handle), counter);
+    ASSERT_TRUE(pool.empty());
+    // the moved-from pool is usable
+    pool.emplace(counter);
+    ASSERT_EQ(counter.use_count(), 4);
+
+    // the items of the assigned pool are destroyed
+    pool = std::move(moved);
+    ASSERT_EQ(counter.use_count(), 3);
+    ASSERT_EQ(pool.at(handle), counter);
+    ASSERT_TRUE(moved.empty());
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+#include "students.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <msf/BasicItem.hpp>
+#include <msf/join.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace msf;
+
+TEST(TestHashJoin, TestJoin) {
+    using Enrollment = BasicItem<3, TextField, IntegerField, IntegerField>;
+    auto students = make_students(3);
+    std::vector<Enrollment> enrollments = {
+        Enrollment(TextField("math"), IntegerField(1), IntegerField(90)),
+        Enrollment(TextField("math"), IntegerField(0), IntegerField(80)),
+        Enrollment(TextField("art"), IntegerField(1), IntegerField(70)),
+        Enrollment(TextField("art"), IntegerField(7), IntegerField(60))};
+
+    auto rows = hash_join<0, 1>(students, enrollments);
+    ASSERT_EQ(rows.size(), 3);
+    // the smaller side is built on and the larger side is scanned in order
+    ASSERT_EQ(rows.at(0).left, &students.at(1));
+    ASSERT_EQ(rows.at(0).right, &enrollments.at(0));
+    ASSERT_EQ(rows.at(1).left, &students.at(0));
+    ASSERT_EQ(rows.at(1).right, &enrollments.at(1));
+    ASSERT_EQ(rows.at(2).left, &students.at(1));
+    ASSERT_EQ(rows.at(2).right, &enrollments.at(2));
+
+    // the same pairs with the sides swapped
+    auto swapped = hash_join<1, 0>(enrollments, students);
+    ASSERT_EQ(swapped.size(), 3);
+    for (size_t i = 0; i < swapped.size(); ++i) {
+        ASSERT_EQ(swapped.at(i).left, rows.at(i).right);
+        ASSERT_EQ(swapped.at(i).right, rows.at(i).left);
+    }
+
+    Integer total = 0;
+    hash_join_each<0, 1>(students, enrollments,
+                         [&total](const Student& s, const Enrollment& e) {
+                             ASSERT_EQ(s.get_field_value<0>(),
+                                       e.get_field_value<1>());
+                             total += e.get_field_value<2>();
+                         });
+    ASSERT_EQ(total, 240);
+}
+
+TEST(TestParallelHashJoin, TestJoin) {
+    using Left = BasicItem<2, IntegerField, IntegerField>;
+    using Right = BasicItem<2, IntegerField, IntegerField>;
+    std::vector<Left> left;
+    std::vector<Right> right;
+    for (Integer i = 0; i < 5000; ++i) {
+        left.emplace_back(IntegerField(i % 1000), IntegerField(i));
+    }
+    for (Integer i = 0; i < 3000; ++i) {
+        right.emplace_back(IntegerField(i), IntegerField(i * 7 % 1500));
+    }
+
+    auto serial = hash_join<0, 1>(left, right);
+    auto parallel = parallel_hash_join<0, 1>(left, right, 4);
+    ASSERT_EQ(parallel.size(), serial.size());
+
+    auto key = [](const JoinedRow<Left, Right>& row) {
+        return std::make_pair(row.left, row.right);
+    };
+    std::vector<std::pair<const Left*, const Right*>> lhs, rhs;
+    std::transform(serial.begin(), serial.end(), std::back_inserter(lhs), key);
+    std::transform(parallel.begin(), parallel.end(), std::back_inserter(rhs),
+                   key);
+    std::sort(lhs.begin(), lhs.end());
+    std::sort(rhs.begin(), rhs.end());
+    ASSERT_EQ(lhs, rhs);
+
+    for (const auto& row : parallel) {
+        ASSERT_EQ(row.left->get_field_value<0>(),
+                  row.right->get_field_value<1>());
+    }
+    std::vector<Right> empty;
+    ASSERT_TRUE((parallel_hash_join<0, 1>(left, empty).empty()));
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,225 @@
+#include <cstdlib>
+#include <cstdio>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <msf/BasicItem.hpp>
+#include <msf/binary.hpp>
+#include <msf/LsmStore.hpp>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace msf;
+
+using Record = BasicItem<3, IntegerField, TextField, DateField>;
+
+std::string make_directory() {
+    char path[] = "/tmp/msf_lsm_XXXXXX";
+    return mkdtemp(path);
+}
+
+std::vector<std::string> list_files(const std::string& directory) {
+    std::vector<std::string> files;
+    DIR* dir = opendir(directory.c_str());
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            files.push_back(name);
+        }
+    }
+    closedir(dir);
+    return files;
+}
+
+void remove_directory(const std::string& directory) {
+    for (const auto& name : list_files(directory)) {
+        unlink((directory + "/" + name).c_str());
+    }
+    rmdir(directory.c_str());
+}
+
+Record make_record(Integer key, const std::string& name) {
+    return Record(IntegerField(key), TextField(name),
+                  DateField(Date(2020, 1 + key % 12, 1 + key % 28)));
+}
+
+TEST(TestBinaryItem, TestLsmStore) {
+    std::string buf;
+    write_item(buf, make_record(42, "forty-two"));
+    Record out;
+    BinaryReader reader(buf);
+    read_item(reader, out);
+    ASSERT_EQ(reader.remaining(), 0);
+    ASSERT_EQ(out.get_field_strs(),
+              make_record(42, "forty-two").get_field_strs());
+
+    BinaryReader truncated(buf.data(), buf.size() - 1);
+    ASSERT_THROW(read_item(truncated, out), std::runtime_error);
+}
+
+TEST(TestPutGet, TestLsmStore) {
+    std::string directory = make_directory();
+    {
+        LsmStore<Record, 0> store(directory, 100);
+        for (Integer i = 0; i < 1000; ++i) {
+            store.put(make_record(i, "v1"));
+        }
+        for (Integer i = 0; i < 1000; i += 2) {
+            store.put(make_record(i, "v2"));
+        }
+        for (Integer i = 0; i < 1000; i += 10) {
+            store.erase(i);
+        }
+        store.flush();
+
+        Record out;
+        for (Integer i = 0; i < 1000; ++i) {
+            bool found = store.get(i, out);
+            ASSERT_EQ(found, i % 10 != 0);
+            if (found) {
+                ASSERT_EQ(out.get_field_value<1>(), i % 2 ? "v1" : "v2");
+                ASSERT_EQ(out.get_field_value<2>().day, 1 + i % 28);
+            }
+        }
+
+        // the absent keys are mostly ruled out by the Bloom filters
+        size_t skips = store.bloom_skips();
+        for (Integer i = 1000; i < 2000; ++i) {
+            ASSERT_FALSE(store.get(i, out));
+        }
+        ASSERT_GT(store.bloom_skips() - skips, 900 * store.segment_count());
+
+        store.compact();
+        ASSERT_EQ(store.segment_count(), 1);
+        ASSERT_EQ(list_files(directory).size(), 1);
+        ASSERT_TRUE(store.get(999, out));
+        ASSERT_EQ(out.get_field_value<1>(), "v1");
+        ASSERT_FALSE(store.get(990, out));
+
+        store.put(make_record(5, "v3"));
+        store.erase(7);
+    }
+
+    // the memtable is flushed when the store is destroyed
+    {
+        LsmStore<Record, 0> store(directory, 100);
+        ASSERT_EQ(store.segment_count(), 2);
+        Record out;
+        ASSERT_TRUE(store.get(5, out));
+        ASSERT_EQ(out.get_field_value<1>(), "v3");
+        ASSERT_FALSE(store.get(7, out));
+        ASSERT_TRUE(store.get(8, out));
+        ASSERT_EQ(out.get_field_value<1>(), "v2");
+    }
+    remove_directory(directory);
+}
+
+TEST(TestBackgroundCompaction, TestLsmStore) {
+    std::string directory = make_directory();
+    {
+        LsmStore<Record, 1> store(directory, 50, 3);
+        for (Integer i = 0; i < 2000; ++i) {
+            store.put(make_record(i, "key" + std::to_string(i % 700)));
+        }
+        // the merges run behind the flushes
+        store.wait_idle();
+        ASSERT_LT(store.segment_count(), 3);
+
+        Record out;
+        for (Integer i = 1300; i < 2000; ++i) {
+            ASSERT_TRUE(store.get("key" + std::to_string(i % 700), out));
+            ASSERT_EQ(out.get_field_value<0>(), i);
+        }
+    }
+    remove_directory(directory);
+}
+
+TEST(TestRecovery, TestLsmStore) {
+    std::string directory = make_directory();
+    {
+        LsmStore<Record, 0> store(directory, 10);
+        for (Integer i = 0; i < 30; ++i) {
+            store.put(make_record(i, "old"));
+        }
+        store.flush();
+    }
+    // a merged segment left with its inputs by an interrupted compaction
+    std::string merged = directory + "_merged";
+    {
+        LsmStore<Record, 0> store(merged);
+        store.put(make_record(1, "merged"));
+    }
+    for (const auto& name : list_files(merged)) {
+        rename((merged + "/" + name).c_str(),
+               (directory + "/segment-3-1.msf").c_str());
+    }
+    rmdir(merged.c_str());
+    // and an unfinished segment
+    FILE* tmp = fopen((directory + "/segment-9-9.msf.tmp").c_str(), "w");
+    fclose(tmp);
+
+    {
+        LsmStore<Record, 0> store(directory);
+        ASSERT_EQ(store.segment_count(), 1);
+        Record out;
+        ASSERT_TRUE(store.get(1, out));
+        ASSERT_EQ(out.get_field_value<1>(), "merged");
+        ASSERT_FALSE(store.get(2, out));
+    }
+    ASSERT_EQ(list_files(directory).size(), 1);
+    remove_directory(directory);
+}
+
+TEST(TestWorkerFailure, TestLsmStore) {
+    std::string directory = make_directory();
+    LsmStore<Record, 0> store(directory, 2);
+    // the flush of the first full table fails without the directory
+    rmdir(directory.c_str());
+    store.put(make_record(1, "lost"));
+    store.put(make_record(2, "lost"));
+    ASSERT_THROW(store.flush(), std::runtime_error);
+    // the later writes report the failure instead of piling up
+    ASSERT_THROW(store.put(make_record(3, "lost")), std::runtime_error);
+    ASSERT_THROW(store.erase(1), std::runtime_error);
+    ASSERT_THROW(store.wait_idle(), std::runtime_error);
+}
+
+TEST(TestCorruptSegment, TestLsmStore) {
+    std::string directory = make_directory();
+    {
+        LsmStore<Record, 0> store(directory);
+        store.put(make_record(1, "one"));
+    }
+    std::string path = directory + "/" + list_files(directory).at(0);
+    FILE* file = fopen(path.c_str(), "r+b");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    // the offset of the Bloom filter, then the count of probes
+    for (long field : {32, 16}) {
+        std::string original(8, '\0');
+        fseek(file, size - field, SEEK_SET);
+        ASSERT_EQ(fread(&original[0], 1, 8, file), 8);
+
+        std::string corrupt(8, field == 32 ? '\xFF' : '\0');
+        fseek(file, size - field, SEEK_SET);
+        fwrite(corrupt.data(), 1, 8, file);
+        fflush(file);
+        ASSERT_THROW((LsmStore<Record, 0>(directory)), std::runtime_error);
+
+        fseek(file, size - field, SEEK_SET);
+        fwrite(original.data(), 1, 8, file);
+        fflush(file);
+    }
+    fclose(file);
+    {
+        LsmStore<Record, 0> store(directory);
+        Record out;
+        ASSERT_TRUE(store.get(1, out));
+    }
+    remove_directory(directory);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <msf/BasicItem.hpp>
+#include <msf/ItemPool.hpp>
+#include <msf/memory.hpp>
+#include <msf/PartitionedItems.hpp>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+using Record = BasicItem<3, BooleanField, TextField, IntegerField>;
+
+static_assert(IntegerField::inline_size() == sizeof(IntegerField),
+              "the inline size of a field is its size");
+static_assert(Record::inline_size() == sizeof(Record),
+              "the inline size of an item is its size");
+static_assert(Record::padding_size() == 0,
+              "the fields are padded to the alignment of their vptr");
+
+TEST(TestFields, TestMemory) {
+    IntegerField integer(42);
+    auto usage = integer.memory_usage();
+    ASSERT_EQ(usage.inline_bytes, sizeof(IntegerField));
+    // the vptr
+    ASSERT_EQ(usage.overhead_bytes, sizeof(void*));
+    ASSERT_EQ(usage.heap_bytes, 0);
+
+    BooleanField boolean(true);
+    ASSERT_EQ(boolean.memory_usage().overhead_bytes,
+              sizeof(BooleanField) - sizeof(bool));
+
+    TextField small("abc");
+    ASSERT_EQ(small.memory_usage().heap_bytes, 0);
+
+    TextField large(std::string(100, 'x'));
+    large.value().reserve(200);
+    usage = large.memory_usage();
+    ASSERT_EQ(usage.heap_bytes, large.value().capacity() + 1);
+    ASSERT_EQ(usage.wasted_bytes, large.value().capacity() - 100);
+    ASSERT_EQ(usage.total_bytes(), sizeof(TextField) + usage.heap_bytes);
+}
+
+TEST(TestItems, TestMemory) {
+    Record record(BooleanField(true), TextField(std::string(50, 'y')),
+                  IntegerField(1));
+    auto fields = record.field_memory_usage();
+    ASSERT_EQ(fields.at(0), BooleanField().memory_usage());
+    ASSERT_EQ(fields.at(1).inline_bytes, sizeof(TextField));
+    ASSERT_EQ(fields.at(1).heap_bytes,
+              record.get_field_value<1>().capacity() + 1);
+
+    auto usage = record.memory_usage();
+    ASSERT_EQ(usage.inline_bytes, sizeof(Record));
+    ASSERT_EQ(usage.heap_bytes, fields.at(1).heap_bytes);
+    ASSERT_EQ(usage.overhead_bytes, fields.at(0).overhead_bytes +
+                                        fields.at(1).overhead_bytes +
+                                        fields.at(2).overhead_bytes);
+
+    std::vector<Record> records(10, record);
+    records.reserve(16);
+    auto total = memory_usage(records);
+    ASSERT_EQ(total.inline_bytes, sizeof(records));
+    ASSERT_EQ(total.heap_bytes, 16 * sizeof(Record) + 10 * usage.heap_bytes);
+    ASSERT_EQ(total.wasted_bytes,
+              6 * sizeof(Record) + 10 * usage.wasted_bytes);
+    ASSERT_EQ(field_memory_usage(records).at(1).heap_bytes,
+              10 * usage.heap_bytes);
+}
+
+TEST(TestContainers, TestMemory) {
+    ItemPool<Record, std::uint32_t, 16> pool;
+    for (int i = 0; i < 10; ++i) {
+        pool.emplace(BooleanField(false), TextField(std::string(40, 'z')),
+                     IntegerField(i));
+    }
+    auto item = pool.begin()->memory_usage();
+    auto usage = pool.memory_usage();
+    ASSERT_GE(usage.heap_bytes, 16 * sizeof(Record) + 10 * item.heap_bytes);
+    ASSERT_EQ(usage.overhead_bytes, 10 * item.overhead_bytes);
+
+    // the items left by clear() hold their heap storage until reused
+    pool.clear();
+    auto cleared = pool.memory_usage();
+    ASSERT_EQ(cleared.heap_bytes, usage.heap_bytes);
+    ASSERT_EQ(cleared.wasted_bytes, cleared.heap_bytes);
+
+    ItemPool<std::shared_ptr<int>> pointers;
+    pointers.emplace(std::make_shared<int>(1));
+    ASSERT_EQ(pointers.memory_usage().overhead_bytes, 0);
+
+    using Admission = BasicItem<2, IntegerField, DateField>;
+    PartitionedItems<Admission, 1> admissions;
+    admissions.insert(Admission(IntegerField(1), DateField(Date(2020, 1, 1))));
+    admissions.insert(Admission(IntegerField(2), DateField(Date(2020, 2, 1))));
+    auto partitioned = admissions.memory_usage();
+    ASSERT_EQ(partitioned.inline_bytes, sizeof(admissions));
+    ASSERT_GE(partitioned.heap_bytes, 2 * sizeof(Admission));
+    ASSERT_EQ(partitioned.overhead_bytes,
+              2 * Admission(IntegerField(1), DateField(Date(2020, 1, 1)))
+                      .memory_usage()
+                      .overhead_bytes);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
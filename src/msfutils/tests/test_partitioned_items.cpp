@@ -0,0 +1,110 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <msf/BasicItem.hpp>
+#include <msf/PartitionedItems.hpp>
+#include <stdexcept>
+#include <vector>
+
+using namespace msf;
+
+using Admission = BasicItem<2, IntegerField, DateField>;
+using Event = BasicItem<2, IntegerField, DateTimeField>;
+
+PartitionedItems<Admission, 1> make_admissions() {
+    PartitionedItems<Admission, 1> admissions;
+    // one admission a day from 2019-01-01 to 2021-12-31
+    for (Integer day = 17897; day < 17897 + 1096; ++day) {
+        admissions.insert(Admission(
+            IntegerField(day), DateField(Date::from_days_since_epoch(day))));
+    }
+    return admissions;
+}
+
+TEST(TestPartitions, TestPartitionedItems) {
+    auto admissions = make_admissions();
+    ASSERT_EQ(admissions.size(), 1096);
+    ASSERT_EQ(admissions.partition_count(), 36);
+    ASSERT_EQ(admissions.partition_of(Date(2020, 2, 29)), 2020 * 12 + 1);
+    ASSERT_EQ(admissions.partition_start(2020 * 12 + 1), Date(2020, 2, 1));
+    ASSERT_EQ(admissions.partition(2020 * 12 + 1)->size(), 29);
+    ASSERT_EQ(admissions.partition(2018 * 12), nullptr);
+
+    PartitionedItems<Admission, 1> daily(PartitionGranularity::Day);
+    ASSERT_EQ(daily.partition_start(daily.partition_of(Date(1969, 12, 31))),
+              Date(1969, 12, 31));
+    ASSERT_EQ(admissions.partition_start(-1), Date(-1, 12, 1));
+}
+
+TEST(TestRange, TestPartitionedItems) {
+    auto admissions = make_admissions();
+    auto selected =
+        admissions.select_range(Date(2020, 2, 10), Date(2020, 4, 5));
+    ASSERT_EQ(selected.size(), 20 + 31 + 5);
+    ASSERT_EQ(selected.front()->get_field_value<1>(), Date(2020, 2, 10));
+    ASSERT_EQ(selected.back()->get_field_value<1>(), Date(2020, 4, 5));
+    ASSERT_TRUE(
+        admissions.select_range(Date(2020, 4, 5), Date(2020, 2, 10)).empty());
+
+    std::atomic<Integer> sum(0);
+    std::atomic<size_t> count(0);
+    admissions.parallel_for_each_in_range(
+        Date(2019, 6, 15), Date(2021, 6, 14), [&](const Admission& item) {
+            sum += item.get_field_value<0>();
+            ++count;
+        },
+        4);
+    Integer expected = 0;
+    admissions.for_each_in_range(
+        Date(2019, 6, 15), Date(2021, 6, 14),
+        [&](const Admission& item) { expected += item.get_field_value<0>(); });
+    ASSERT_EQ(count, 731);
+    ASSERT_EQ(sum, expected);
+
+    ASSERT_THROW(admissions.parallel_for_each_in_range(
+                     Date(2019, 1, 1), Date(2021, 12, 31),
+                     [](const Admission& item) {
+                         if (item.get_field_value<1>() == Date(2020, 7, 1)) {
+                             throw std::runtime_error("stop");
+                         }
+                     }),
+                 std::runtime_error);
+}
+
+TEST(TestRetention, TestPartitionedItems) {
+    auto admissions = make_admissions();
+    ASSERT_EQ(admissions.drop_before(Date(2020, 1, 15)), 365);
+    ASSERT_EQ(admissions.partition_count(), 24);
+    ASSERT_EQ(admissions.size(), 731);
+
+    const Admission* first = &admissions.partition(2020 * 12)->front();
+    auto archived = admissions.archive(2020 * 12);
+    ASSERT_EQ(archived.size(), 31);
+    ASSERT_EQ(&archived.front(), first);
+    ASSERT_EQ(admissions.size(), 700);
+    ASSERT_TRUE(admissions.archive(2020 * 12).empty());
+
+    ASSERT_TRUE(admissions.drop(2021 * 12 + 11));
+    ASSERT_FALSE(admissions.drop(2021 * 12 + 11));
+    ASSERT_EQ(admissions.size(), 669);
+    ASSERT_EQ(admissions.partition_keys().front(), 2020 * 12 + 1);
+}
+
+TEST(TestDateTime, TestPartitionedItems) {
+    PartitionedItems<Event, 1> events(PartitionGranularity::Day);
+    for (Integer hour = 0; hour < 24 * 10; ++hour) {
+        events.insert(Event(IntegerField(hour),
+                            DateTimeField(DateTime::from_seconds_since_epoch(
+                                1600000000 + hour * 3600))));
+    }
+    ASSERT_EQ(events.partition_count(), 11);
+    auto first = DateTime::from_seconds_since_epoch(1600000000 + 5 * 3600);
+    auto last = DateTime::from_seconds_since_epoch(1600000000 + 100 * 3600);
+    auto selected = events.select_range(first, last);
+    ASSERT_EQ(selected.size(), 96);
+    ASSERT_EQ(selected.front()->get_field_value<0>(), 5);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
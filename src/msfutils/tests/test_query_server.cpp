@@ -0,0 +1,177 @@
+#include "students.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <msf/binary.hpp>
+#include <msf/QueryServer.hpp>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace msf;
+
+class TestQueryServer : public ::testing::Test {
+protected:
+    std::vector<Student> students;
+    std::string path;
+    std::unique_ptr<QueryServer<Student, 0>> server;
+    std::thread loop;
+
+    void SetUp() override {
+        // the ids 0 to 999 in reverse order
+        students = make_students(1000);
+        std::reverse(students.begin(), students.end());
+        path = "/tmp/msf_query_" + std::to_string(getpid()) + ".sock";
+        server.reset(new QueryServer<Student, 0>(students, path));
+        loop = std::thread([this] { server->run(); });
+    }
+
+    void TearDown() override {
+        server->stop();
+        loop.join();
+        server.reset();
+        ASSERT_NE(access(path.c_str(), F_OK), 0);
+    }
+};
+
+/**
+ * @brief read exactly size bytes from a socket
+ */
+void read_exactly(int fd, char* buf, size_t size) {
+    size_t received = 0;
+    while (received < size) {
+        ssize_t res = recv(fd, buf + received, size - received, 0);
+        ASSERT_GT(res, 0);
+        received += res;
+    }
+}
+
+TEST_F(TestQueryServer, TestLookup) {
+    QueryClient<Student, 0> client(path);
+    auto res = client.lookup({1, 1000, 999, -3}, (1 << 0) | (1 << 1));
+    ASSERT_EQ(res.status, QueryStatus::Ok);
+    ASSERT_EQ(res.op, QueryOp::Lookup);
+    ASSERT_EQ(res.found, std::vector<bool>({true, false, true, false}));
+    ASSERT_EQ(res.items.at(0).get_field_value<1>(), "student37");
+    ASSERT_EQ(res.items.at(2).get_field_value<0>(), 999);
+    ASSERT_EQ(res.items.at(2).get_field_value<1>(), "student36963");
+    // the fields out of the mask are not sent
+    ASSERT_EQ(res.items.at(2).get_field_value<3>(), 0.0);
+}
+
+TEST_F(TestQueryServer, TestScan) {
+    QueryClient<Student, 0> client(path);
+    auto res = client.scan(10, 30);
+    ASSERT_EQ(res.status, QueryStatus::Ok);
+    ASSERT_EQ(res.items.size(), 21);
+    ASSERT_EQ(res.items.front().get_field_value<0>(), 10);
+    ASSERT_EQ(res.items.back().get_field_value<0>(), 30);
+    ASSERT_EQ(res.items.back().get_field_value<3>(), 142.5);
+
+    res = client.scan(0, 100000, 5, 1 << 3);
+    ASSERT_EQ(res.items.size(), 5);
+    ASSERT_EQ(res.items.at(4).get_field_value<3>(), 169.0);
+    ASSERT_EQ(res.items.at(4).get_field_value<0>(), 0);
+    ASSERT_TRUE(client.scan(30, 10).items.empty());
+}
+
+TEST_F(TestQueryServer, TestPipelining) {
+    QueryClient<Student, 0> first(path);
+    QueryClient<Student, 0> second(path);
+    std::vector<std::uint64_t> ids;
+    for (Integer i = 0; i < 500; ++i) {
+        ids.push_back(first.send_lookup({i, i + 1000}));
+        second.send_scan(i, i + 5);
+    }
+    // the queued requests go out in one write
+    first.flush();
+    for (Integer i = 0; i < 500; ++i) {
+        auto res = first.receive();
+        ASSERT_EQ(res.id, ids.at(i));
+        ASSERT_EQ(res.found, std::vector<bool>({true, false}));
+        ASSERT_EQ(res.items.at(0).get_field_value<0>(), i);
+
+        res = second.receive();
+        ASSERT_EQ(res.items.size(), 6);
+    }
+}
+
+TEST_F(TestQueryServer, TestHalfClose) {
+    QueryClient<Student, 0> client(path);
+    // far more responses than the server holds before it stops reading
+    for (int i = 0; i < 200; ++i) {
+        client.send_scan(0, 999);
+    }
+    client.finish();
+    for (int i = 0; i < 200; ++i) {
+        auto res = client.receive();
+        ASSERT_EQ(res.status, QueryStatus::Ok);
+        ASSERT_EQ(res.items.size(), 1000);
+        ASSERT_EQ(res.items.back().get_field_value<1>(), "student36963");
+    }
+    ASSERT_THROW(client.receive(), std::runtime_error);
+}
+
+TEST_F(TestQueryServer, TestMalformed) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)),
+              0);
+
+    // an unknown operation, then a lookup cut short
+    std::string out;
+    write_unsigned(out, 17, 4);
+    write_unsigned(out, 7, 8);
+    write_unsigned(out, 9, 1);
+    write_unsigned(out, all_fields, 8);
+    write_unsigned(out, 19, 4);
+    write_unsigned(out, 8, 8);
+    write_unsigned(out, static_cast<int>(QueryOp::Lookup), 1);
+    write_unsigned(out, all_fields, 8);
+    write_unsigned(out, 1, 2);
+    ASSERT_EQ(send(fd, out.data(), out.size(), 0), out.size());
+
+    for (std::uint64_t id : {7, 8}) {
+        char header[4];
+        read_exactly(fd, header, sizeof(header));
+        size_t length = BinaryReader(header, 4).read_unsigned(4);
+        ASSERT_GE(length, 18u);
+        std::string frame(length, '\0');
+        read_exactly(fd, &frame[0], length);
+
+        BinaryReader reader(frame.data(), frame.size());
+        ASSERT_EQ(reader.read_unsigned(8), id);
+        reader.read_unsigned(1);
+        ASSERT_EQ(reader.read_unsigned(1),
+                  static_cast<int>(QueryStatus::Error));
+        reader.read_unsigned(8);
+        std::string error;
+        reader.read_value(error);
+        ASSERT_FALSE(error.empty());
+        ASSERT_EQ(reader.remaining(), 0u);
+    }
+    close(fd);
+}
+
+TEST(TestQueryServerKeys, TestDuplicateKeys) {
+    auto students = make_students(10);
+    students.push_back(students.at(4));
+    std::string path =
+        "/tmp/msf_query_keys_" + std::to_string(getpid()) + ".sock";
+    ASSERT_THROW((QueryServer<Student, 0>(students, path)),
+                 std::invalid_argument);
+    ASSERT_NE(access(path.c_str(), F_OK), 0);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,83 @@
+#include "students.hpp"
+#include <gtest/gtest.h>
+#include <msf/BasicItem.hpp>
+#include <msf/ResultSet.hpp>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+TEST(TestPaging, TestResultSet) {
+    auto students = make_students(1000);
+    ResultSet<Student> rs(students);
+    rs.where([](const Student& s) { return s.get_field_value<2>(); })
+        .order_by<3>(SortOrder::Descending);
+    ASSERT_EQ(rs.size(), 334);
+
+    auto page = rs.page(10, 10);
+    ASSERT_EQ(page.size(), 10);
+    ASSERT_EQ(rs.formatted_rows(), 10);
+
+    auto rows = stable_sort_by<3>(students, SortOrder::Descending);
+    std::vector<size_t> expected;
+    for (auto row : rows) {
+        if (students.at(row).get_field_value<2>()) {
+            expected.push_back(row);
+        }
+    }
+    for (size_t i = 0; i < page.size(); ++i) {
+        ASSERT_EQ(page.at(i),
+                  students.at(expected.at(10 + i)).get_field_strs());
+    }
+
+    // the repeated page is served from the cache
+    rs.page(10, 10);
+    ASSERT_EQ(rs.formatted_rows(), 10);
+    rs.page(0, 20);
+    ASSERT_EQ(rs.formatted_rows(), 20);
+
+    // a copy takes over the rows not ordered yet
+    ResultSet<Student> copy(rs);
+    ASSERT_EQ(copy.page_rows(0, 400), expected);
+
+    for (size_t offset = 20; offset < 330; offset += 10) {
+        ASSERT_EQ(rs.page_rows(offset, 10),
+                  std::vector<size_t>(expected.begin() + offset,
+                                      expected.begin() + offset + 10));
+    }
+    auto last = rs.page_rows(330, 10);
+    ASSERT_EQ(last.size(), 4);
+    ASSERT_EQ(last.back(), expected.back());
+    ASSERT_TRUE(rs.page(400, 10).empty());
+    ASSERT_EQ(rs.item(0).get_field_value<3>(),
+              students.at(expected.front()).get_field_value<3>());
+}
+
+TEST(TestRuntimeOrder, TestResultSet) {
+    auto students = make_students(10);
+    ResultSet<Student> rs(students, {5, 3, 9, 1, 7}, 2);
+    rs.order_by(1);
+    auto page = rs.page(0, 5);
+    ASSERT_EQ(page.at(0).at(1), "student111");
+    ASSERT_EQ(page.at(4).at(1), "student37");
+    ASSERT_EQ(rs.formatted_rows(), 5);
+
+    // only the two most recent rows are kept
+    rs.page(3, 2);
+    ASSERT_EQ(rs.formatted_rows(), 5);
+    rs.page(0, 1);
+    ASSERT_EQ(rs.formatted_rows(), 6);
+
+    // the rows are filtered and ordered again halfway through an ordering
+    rs.order_by(3, SortOrder::Ascending);
+    ASSERT_EQ(rs.row(0), 9);
+    rs.where([](const Student& s) { return s.get_field_value<0>() != 7; });
+    ASSERT_EQ(rs.page_rows(0, 5), std::vector<size_t>({9, 5, 3, 1}));
+    ASSERT_THROW(rs.order_by(6), std::out_of_range);
+    ASSERT_THROW(rs.row(4), std::out_of_range);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <msf/BasicItem.hpp>
+#include <msf/sort.hpp>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+using Record = BasicItem<6, TextField, BooleanField, DateTimeField,
+                         IntegerField, FloatField, DateField>;
+
+std::vector<Record> make_records() {
+    std::vector<Record> records;
+    for (Integer i = 0; i < 500; ++i) {
+        Integer key = (i * 7919) % 97 - 48;
+        records.emplace_back(
+            TextField("name" + std::to_string(i % 13)),
+            BooleanField(i % 2 == 0),
+            DateTimeField(DateTime::from_seconds_since_epoch(
+                -86400 * 400 + (i * 104729) % 2000 * 86399)),
+            IntegerField(key), FloatField(double(key) / 3),
+            DateField(Date::from_days_since_epoch((i * 31) % 50 - 25)));
+    }
+    return records;
+}
+
+/**
+ * @brief check that the rows are a permutation sorted by a comparator
+ */
+template <typename Less>
+void expect_sorted(const std::vector<Record>& records,
+                   const std::vector<size_t>& rows, Less less) {
+    ASSERT_EQ(rows.size(), records.size());
+    std::vector<size_t> seen(rows);
+    std::sort(seen.begin(), seen.end());
+    for (size_t i = 0; i < seen.size(); ++i) {
+        ASSERT_EQ(seen.at(i), i);
+    }
+    for (size_t i = 1; i < rows.size(); ++i) {
+        ASSERT_FALSE(less(records.at(rows.at(i)), records.at(rows.at(i - 1))));
+    }
+}
+
+TEST(TestRadixSort, TestSort) {
+    auto records = make_records();
+
+    expect_sorted(records, sort_by<3>(records),
+                  [](const Record& lhs, const Record& rhs) {
+                      return lhs.get_field_value<3>() <
+                          rhs.get_field_value<3>();
+                  });
+    expect_sorted(records, sort_by<4>(records),
+                  [](const Record& lhs, const Record& rhs) {
+                      return lhs.get_field_value<4>() <
+                          rhs.get_field_value<4>();
+                  });
+    expect_sorted(records, sort_by<2>(records),
+                  [](const Record& lhs, const Record& rhs) {
+                      return lhs.get_field_value<2>() <
+                          rhs.get_field_value<2>();
+                  });
+    expect_sorted(records, sort_by<1, 5>(records, SortOrder::Descending),
+                  [](const Record& lhs, const Record& rhs) {
+                      if (lhs.get_field_value<1>() !=
+                          rhs.get_field_value<1>()) {
+                          return lhs.get_field_value<1>();
+                      }
+                      return rhs.get_field_value<5>() <
+                          lhs.get_field_value<5>();
+                  });
+}
+
+TEST(TestStableSort, TestSort) {
+    auto records = make_records();
+    auto rows = stable_sort_by<1>(records);
+    for (size_t i = 1; i < rows.size(); ++i) {
+        if (records.at(rows.at(i)).get_field_value<1>() ==
+            records.at(rows.at(i - 1)).get_field_value<1>()) {
+            ASSERT_LT(rows.at(i - 1), rows.at(i));
+        }
+    }
+
+    // a text key falls back to the comparison sort
+    rows = stable_sort_by<0, 3>(records, SortOrder::Descending);
+    expect_sorted(records, rows, [](const Record& lhs, const Record& rhs) {
+        if (lhs.get_field_value<0>() != rhs.get_field_value<0>()) {
+            return rhs.get_field_value<0>() < lhs.get_field_value<0>();
+        }
+        return rhs.get_field_value<3>() < lhs.get_field_value<3>();
+    });
+    for (size_t i = 1; i < rows.size(); ++i) {
+        const auto& lhs = records.at(rows.at(i - 1));
+        const auto& rhs = records.at(rows.at(i));
+        if (lhs.get_field_value<0>() == rhs.get_field_value<0>() &&
+            lhs.get_field_value<3>() == rhs.get_field_value<3>()) {
+            ASSERT_LT(rows.at(i - 1), rows.at(i));
+        }
+    }
+}
+
+TEST(TestTopK, TestSort) {
+    auto records = make_records();
+    auto all = stable_sort_by<5, 3>(records);
+    auto top = top_k_by<5, 3>(records, 25);
+    ASSERT_EQ(top.size(), 25);
+    ASSERT_TRUE(std::equal(top.begin(), top.end(), all.begin()));
+
+    auto text_top = top_k_by<0>(records, 1000);
+    ASSERT_EQ(text_top, stable_sort_by<0>(records));
+
+    std::vector<size_t> subset = {10, 3, 7, 1};
+    partial_sort_indices_by<3>(records, subset, 2);
+    ASSERT_LE(records.at(subset.at(0)).get_field_value<3>(),
+              records.at(subset.at(1)).get_field_value<3>());
+    for (size_t i = 2; i < subset.size(); ++i) {
+        ASSERT_LE(records.at(subset.at(1)).get_field_value<3>(),
+                  records.at(subset.at(i)).get_field_value<3>());
+    }
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
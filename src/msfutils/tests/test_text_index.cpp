@@ -0,0 +1,136 @@
+#include "students.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <msf/BasicItem.hpp>
+#include <msf/TextIndex.hpp>
+#include <string>
+#include <vector>
+
+using namespace msf;
+
+std::vector<size_t> scan(const std::vector<Student>& records,
+                         const std::string& pattern, bool prefix) {
+    std::vector<size_t> res;
+    for (size_t row = 0; row < records.size(); ++row) {
+        auto pos = records.at(row).get_field_value<1>().find(pattern);
+        if (prefix ? pos == 0 : pos != std::string::npos) {
+            res.push_back(row);
+        }
+    }
+    return res;
+}
+
+TEST(TestQueries, TestTextIndex) {
+    auto records = make_students(2000);
+    TextIndex<Student, 1> index(records);
+    ASSERT_EQ(index.size(), 2000);
+
+    for (std::string pattern :
+         {"student1", "student37", "student7399", "7", "", "99", "123",
+          "4440", "studentx", "t12"}) {
+        auto found = index.find_substring(pattern);
+        ASSERT_EQ(found, scan(records, pattern, false)) << pattern;
+
+        found = index.find_prefix(pattern);
+        std::sort(found.begin(), found.end());
+        ASSERT_EQ(found, scan(records, pattern, true)) << pattern;
+    }
+
+    // the prefix matches come in the order of their values
+    auto found = index.find_prefix("student11", 3);
+    ASSERT_EQ(found.size(), 3);
+    ASSERT_EQ(records.at(found.at(0)).get_field_value<1>(), "student11026");
+    ASSERT_EQ(records.at(found.at(1)).get_field_value<1>(), "student11063");
+    ASSERT_EQ(records.at(found.at(2)).get_field_value<1>(), "student111");
+}
+
+TEST(TestUpdates, TestTextIndex) {
+    auto records = make_students(2001);
+    TextIndex<Student, 1> index;
+    for (size_t row = 0; row < 2000; ++row) {
+        index.insert(row, records.at(row));
+    }
+
+    for (size_t row = 0; row < 2000; row += 3) {
+        records.at(row).get_field_value<1>() = "admin" + std::to_string(row);
+        index.update(row, records.at(row));
+    }
+    for (size_t row = 1; row < 2000; row += 5) {
+        ASSERT_TRUE(index.erase(row));
+    }
+    ASSERT_FALSE(index.erase(1));
+    ASSERT_FALSE(index.contains(6));
+    ASSERT_TRUE(index.contains(3));
+
+    records.back().get_field_value<1>() = "admin-new";
+    index.insert(2000, records.back());
+
+    for (std::string pattern :
+         {"admin", "student", "min1", "ent8", "-new", "3"}) {
+        auto expected = scan(records, pattern, false);
+        expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                      [](size_t row) {
+                                          return row < 2000 && row % 5 == 1;
+                                      }),
+                       expected.end());
+        ASSERT_EQ(index.find_substring(pattern), expected) << pattern;
+
+        auto found = index.find_prefix(pattern);
+        std::sort(found.begin(), found.end());
+        expected = scan(records, pattern, true);
+        expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                      [](size_t row) {
+                                          return row < 2000 && row % 5 == 1;
+                                      }),
+                       expected.end());
+        ASSERT_EQ(found, expected) << pattern;
+
+        // the limited prefix matches are the first ones in value order
+        auto ordered = index.find_prefix(pattern);
+        ASSERT_EQ(index.find_prefix(pattern, 5),
+                  std::vector<size_t>(ordered.begin(),
+                                      ordered.begin() +
+                                          std::min<size_t>(5, ordered.size())))
+            << pattern;
+        for (size_t i = 1; i < ordered.size(); ++i) {
+            ASSERT_LE(records.at(ordered.at(i - 1)).get_field_value<1>(),
+                      records.at(ordered.at(i)).get_field_value<1>());
+        }
+    }
+}
+
+TEST(TestCopy, TestTextIndex) {
+    auto records = make_students(1000);
+    TextIndex<Student, 1> index(records);
+    // fewer removals than a merge takes, they are skipped by the queries
+    for (size_t row = 0; row < 100; ++row) {
+        ASSERT_TRUE(index.erase(row));
+    }
+    index.insert(5, records.at(5));
+    auto found = index.find_prefix("student");
+    ASSERT_EQ(found.size(), 901);
+    ASSERT_EQ(std::count(found.begin(), found.end(), 5), 1);
+    ASSERT_EQ(std::count(found.begin(), found.end(), 6), 0);
+
+    TextIndex<Student, 1> copy(index);
+    for (size_t row = 100; row < 200; ++row) {
+        ASSERT_TRUE(index.erase(row));
+    }
+    ASSERT_EQ(copy.find_prefix("student"), found);
+    ASSERT_EQ(copy.find_substring("student").size(), 901);
+    ASSERT_EQ(index.find_substring("student").size(), 801);
+
+    copy = index;
+    ASSERT_EQ(copy.size(), 801);
+    ASSERT_EQ(copy.find_prefix("student"), index.find_prefix("student"));
+    for (size_t row = 200; row < 1000; ++row) {
+        ASSERT_TRUE(copy.erase(row));
+    }
+    ASSERT_EQ(copy.find_prefix("student"), std::vector<size_t> {5});
+    ASSERT_EQ(index.size(), 801);
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}
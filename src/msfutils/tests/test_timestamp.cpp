@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <msf/fields.hpp>
+#include <msf/timestamp.hpp>
+#include <vector>
+
+using namespace msf;
+
+TEST(TestParseDates, TestTimestamp) {
+    std::vector<string> strs = {"2024-09-01", "2024-02-29", "2023-02-29",
+                                "2024-13-01", "2024-9-01",  "2024/09/01",
+                                "2024-04-31", "1999-12-31", "20a4-09-01"};
+    std::vector<Date> dates(strs.size());
+    std::vector<std::uint64_t> errors(error_bitmap_size(strs.size()));
+
+    ASSERT_EQ(parse_dates(strs.data(), strs.size(), dates.data(),
+                          errors.data()),
+              6);
+
+    std::vector<bool> expected = {false, false, true, true, true,
+                                  true,  true,  false, true};
+    for (size_t i = 0; i < strs.size(); ++i) {
+        ASSERT_EQ(has_error(errors.data(), i), expected.at(i)) << strs.at(i);
+    }
+    ASSERT_EQ(dates.at(0), Date(2024, 9, 1));
+    ASSERT_EQ(dates.at(1), Date(2024, 2, 29));
+    ASSERT_EQ(dates.at(7), Date(1999, 12, 31));
+    ASSERT_EQ(dates.at(2), Date());
+}
+
+TEST(TestParseTimes, TestTimestamp) {
+    std::vector<string> strs = {"00:02:04", "23:59:59", "24:00:00",
+                                "12:60:00", "12-00-00", "1:00:00"};
+    std::vector<Time> times(strs.size());
+    std::vector<std::uint64_t> errors(error_bitmap_size(strs.size()));
+
+    ASSERT_EQ(parse_times(strs.data(), strs.size(), times.data(),
+                          errors.data()),
+              4);
+    ASSERT_FALSE(has_error(errors.data(), 0));
+    ASSERT_FALSE(has_error(errors.data(), 1));
+    ASSERT_EQ(times.at(0), Time(0, 2, 4));
+    ASSERT_EQ(times.at(1), Time(23, 59, 59));
+}
+
+TEST(TestParseDateTimes, TestTimestamp) {
+    // more than one word of error bits
+    std::vector<DateTime> expected;
+    std::vector<string> strs;
+    for (int i = 0; i < 130; ++i) {
+        expected.emplace_back(2024, 12, 1 + i % 28, i % 24, i % 60, 59);
+        strs.push_back(DateTimeField(expected.back()).str());
+    }
+    strs.at(65) = "2024-12-25T00:21:24";
+    strs.at(129) = "2024-12-25 00:21:60";
+
+    std::vector<DateTime> values(strs.size());
+    std::vector<std::uint64_t> errors(error_bitmap_size(strs.size()));
+    ASSERT_EQ(errors.size(), 3);
+    ASSERT_EQ(parse_date_times(strs.data(), strs.size(), values.data(),
+                               errors.data()),
+              2);
+
+    for (size_t i = 0; i < strs.size(); ++i) {
+        if (i == 65 || i == 129) {
+            ASSERT_TRUE(has_error(errors.data(), i));
+        } else {
+            ASSERT_FALSE(has_error(errors.data(), i));
+            ASSERT_EQ(values.at(i), expected.at(i));
+        }
+    }
+}
+
+TEST(TestTryParse, TestTimestamp) {
+    DateTime dt;
+    ASSERT_TRUE(try_parse_date_time("2024-12-25 00:21:24", dt));
+    ASSERT_EQ(dt, DateTime(2024, 12, 25, 0, 21, 24));
+    ASSERT_FALSE(try_parse_date_time("2024-12-25 00:21:2", dt));
+    ASSERT_FALSE(try_parse_date_time("2024-12-25 00:21:24 ", dt));
+
+    Date d;
+    ASSERT_TRUE(try_parse_date("2000-02-29", d));
+    ASSERT_FALSE(try_parse_date("1900-02-29", d));
+    ASSERT_FALSE(try_parse_date("2000-02-30", d));
+
+    Time t;
+    ASSERT_TRUE(try_parse_time("08:30:00", t));
+    ASSERT_EQ(t, Time(8, 30, 0));
+}
+
+int main() {
+    ::testing::InitGoogleTest();
+    return RUN_ALL_TESTS();
+}